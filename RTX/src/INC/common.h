@@ -78,7 +78,7 @@
 #define TID_KCD             159     /* pre-defined Task ID for KCD task */
 #define TID_UART_IRQ        0xFF    /* reserved TID for UART IRQ handler which is not a task */
 #define MAX_TASKS           160     /* maximum number of tasks in the system */
-#define K_STACK_SIZE        0x200   /* task kernel stack size in bytes */
+#define K_STACK_SIZE        0x400   /* task kernel stack size in bytes, room for nested IRQs */
 #define U_STACK_SIZE        0x200   /* task user space stack size in bytes */
 
 /* Real-time Task Priority. Highest in the system*/
@@ -88,6 +88,7 @@
 #define LOW                 102
 #define LOWEST              103
 #define PRIO_NULL           255     /* hidden priority for null task */
+#define PRIO_KERNEL         1       /* hidden priority for the IRQ worker, above every user task */
 
 /* Task States */
 #define DORMANT             0       /* terminated task state */
@@ -188,9 +189,15 @@ typedef struct rtx_task_info {
     U8                  prio;               /**> execution priority                 */
     U8                  state;              /**> task state                         */
     U8                  priv;               /**> = 0 unprivileged, =1 privileged    */
+    U8                  affinity;           /**> CPUs the task may run on, 0 = any  */
     /* The following only applies to real-time tasks */
     TIMEVAL             p_n;                /**> period in seconds and microseconds */
     size_t              rt_mbx_size;        /**> real-time task mailbox capacity    */
+    /* Run time statistics, filled in by tsk_get_info and ignored on create */
+    U64                 run_time_us;        /**> time spent running, IRQs taken included */
+    U64                 last_run_us;        /**> when it last got a CPU, us since boot  */
+    U32                 nvcsw;              /**> voluntary switches: blocked or exited  */
+    U32                 nivcsw;             /**> involuntary: preempted or yielded      */
 } RTX_TASK_INFO;
 
 /**
@@ -201,6 +208,7 @@ typedef struct task_rt {
     void                (*task_entry)();    /**> task entry address                 */
     U16                 u_stack_size;       /**> user stack size in bytes           */
     size_t              rt_mbx_size;        /**> mailbox size in bytes              */
+    U8                  affinity;           /**> CPUs the task may run on, 0 = any  */
 } TASK_RT;
 
 #endif // ! COMMON_H_
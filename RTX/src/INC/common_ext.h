@@ -55,6 +55,65 @@
  #define ALLOCATED      1
  #define FREE           0
 
+ /* Task States, continued from common.h */
+ #define BLK_CALL       6       /* blocked in msg_call until the server receives */
+ #define BLK_REPLY      7       /* blocked in msg_call until the server replies */
+ #define BLK_RECV       8       /* blocked in msg_receive until a client calls */
+ #define BLK_TOPIC      9       /* blocked in topic_recv until a sample is published */
+ #define BLK_UART       10      /* blocked in uart_rx_recv until a character arrives */
+ #define BLK_DEFER      11      /* IRQ worker waiting for deferred interrupt work */
+ #define BLK_NOTIFY     12      /* blocked in tsk_wait_notify until notified or timed out */
+ #define BLK_SEM        13      /* blocked in sem_wait until a post hands it the count */
+ #define BLK_MUTEX      14      /* blocked in mutex_lock until the owner hands it over */
+ #define EXITING        15      /* exited, DORMANT once the next task has switched in */
+
+ /* Reserved Task IDs, continued from common.h */
+ #define TID_IRQ_WORKER 158     /* kernel task that runs work deferred by IRQ handlers */
+ #define TID_NULL_CPU1  157     /* null task of CPU 1, CPU 0 runs TID_NULL */
+
+ /* Publish/Subscribe */
+ #define TOPIC_NAME_LEN 8       /* topic names are compared up to this many chars */
+
+ /* Task Notifications */
+ #define NOTIFY_SET_BITS    0   /* OR the bits into the notification word */
+ #define NOTIFY_INCREMENT   1   /* add one to the notification word, bits is ignored */
+ #define NOTIFY_OVERWRITE   2   /* replace the notification word with bits */
+ #define TIMEOUT_FOREVER    0xFFFFFFFF
+
+ /* Event Trace, trace_ctl commands */
+ #define TRACE_START    0       /* empty the trace rings and start recording */
+ #define TRACE_STOP     1
+ #define TRACE_DUMP     2       /* stop and print the rings for tools/trace2json.py */
+
+ /* Profiler, prof_ctl commands */
+ #define PROF_START     0       /* empty the sample buffer and sample every period_us */
+ #define PROF_STOP      1
+ #define PROF_DUMP      2       /* stop and print the samples for tools/profile.py */
+ #define PROF_MIN_PERIOD_US 50  /* shortest sampling period prof_ctl accepts */
+
+ /* PMU, pmu_select event numbers from the Cortex-A9 TRM */
+ #define PMU_NUM_COUNTERS       6
+ #define PMU_EV_OFF             0xFFFF  /* release the counter */
+ #define PMU_EV_ICACHE_MISS     0x01    /* instruction cache refills */
+ #define PMU_EV_DCACHE_MISS     0x03    /* data cache refills */
+ #define PMU_EV_DCACHE_ACCESS   0x04
+ #define PMU_EV_DTLB_MISS       0x05
+ #define PMU_EV_EXCEPTION       0x09    /* exceptions taken, IRQs and SVCs included */
+ #define PMU_EV_BRANCH_MISS     0x10    /* branches mispredicted or not predicted */
+ #define PMU_EV_BRANCH          0x12    /* branches that could have been predicted */
+ #define PMU_EV_DCACHE_STALL    0x61    /* cycles stalled on a data cache miss */
+ #define PMU_EV_INSTR           0x68    /* instructions out of the renaming stage, the A9's retired count */
+
+ /* Task CPU Affinity, bit n of the mask lets the task run on CPU n */
+ #define AFFINITY_ANY       0x00                /* every CPU, the default */
+ #define AFFINITY_CPU(n)    (1 << (n))
+
+ /* Software Timers */
+ #define TIMER_ONESHOT  0       /* fire once, the timer stays allocated until timer_delete */
+ #define TIMER_PERIODIC 1       /* fire every period until timer_delete */
+ #define TIMER_CALLBACK 0       /* run fn(arg) in the IRQ worker task, privileged callers only */
+ #define TIMER_TOPIC    1       /* publish an RTX_TIMER_EVENT on a topic */
+
 /*
  *===========================================================================
  *                             TYPEDEFS
@@ -75,12 +134,266 @@
      U32 check;
  } header;
 
+ /**
+  * @brief interrupt handler, returns non-zero if the current task should be rescheduled
+  */
+ typedef int (*IRQ_HANDLER)(U32 irq_id, void *arg);
+
+ /**
+  * @brief per interrupt statistics kept by the dispatcher
+  */
+ typedef struct rtx_irq_stats {
+     U32 count;         /* times the handler ran */
+     U32 max_cycles;    /* longest handler run in CPU cycles */
+     U32 max_total;     /* longest IRQ_Handler entry to exit in CPU cycles, nested interrupts included */
+     U32 defer_dropped; /* work items any handler failed to defer because the queue was full */
+ } RTX_IRQ_STATS;
+
+ /**
+  * @brief what a software timer does when it fires
+  */
+ typedef struct rtx_timer_action {
+     U8 type;                   /* TIMER_CALLBACK or TIMER_TOPIC */
+     void (*fn)(void *arg);     /* TIMER_CALLBACK: function to run */
+     void *arg;                 /* TIMER_CALLBACK: its argument */
+     int topic;                 /* TIMER_TOPIC: topic to publish on */
+ } RTX_TIMER_ACTION;
+
+ /**
+  * @brief sample published by a TIMER_TOPIC timer
+  */
+ typedef struct rtx_timer_event {
+     int timer;                 /* timer that fired */
+     U32 expiries;              /* periods elapsed since the last event, more than 1 on overrun */
+ } RTX_TIMER_EVENT;
+
+ /**
+  * @brief PMU counts of a task, filled in by pmu_read
+  */
+ typedef struct rtx_pmu_counts {
+     U64 cycles;                    /* CPU cycles run since the first pmu_select */
+     U64 count[PMU_NUM_COUNTERS];   /* events since the counter was selected */
+     U16 event[PMU_NUM_COUNTERS];   /* what each counter counts, PMU_EV_OFF if unused */
+ } RTX_PMU_COUNTS;
+
+ /**
+  * @brief buffer descriptor used by the send/receive/reply primitives
+  */
+ typedef struct rtx_iov {
+     void *base;        /* start of the buffer */
+     size_t len;        /* length of the buffer in bytes */
+ } RTX_IOV;
+
  /*
   *===========================================================================
   *                            FUNCTION PROTOTYPES
   *===========================================================================
   */
 
+ /*------------------------------------------------------------------------*
+  * Synchronous Send/Receive/Reply Functions
+  *------------------------------------------------------------------------*/
+
+ /* the request and reply buffers are passed by descriptor so the trap stays within R0-R3 */
+ extern int k_msg_call(task_t tid, const RTX_IOV *req, RTX_IOV *reply);
+ #define msg_call(tid, req, req_len, reply, reply_len) \
+         _msg_call((U32)k_msg_call, tid, &(RTX_IOV){(void *)(req), (req_len)}, &(RTX_IOV){(reply), (reply_len)})
+ extern int __svc_indirect(0) _msg_call(U32 p_func, task_t tid, const RTX_IOV *req, RTX_IOV *reply);
+
+ extern int k_msg_receive(task_t *tid, void *buf, size_t len);
+ #define msg_receive(tid, buf, len) _msg_receive((U32)k_msg_receive, tid, buf, len)
+ extern int __svc_indirect(0) _msg_receive(U32 p_func, task_t *tid, void *buf, size_t len);
+
+ extern int k_msg_reply(task_t tid, const void *buf, size_t len);
+ #define msg_reply(tid, buf, len) _msg_reply((U32)k_msg_reply, tid, buf, len)
+ extern int __svc_indirect(0) _msg_reply(U32 p_func, task_t tid, const void *buf, size_t len);
+
+ /*------------------------------------------------------------------------*
+  * Publish/Subscribe Functions
+  *------------------------------------------------------------------------*/
+
+ extern int k_topic_open(const char *name);
+ #define topic_open(name) _topic_open((U32)k_topic_open, name)
+ extern int __svc_indirect(0) _topic_open(U32 p_func, const char *name);
+
+ extern int k_topic_subscribe(int topic);
+ #define topic_subscribe(topic) _topic_subscribe((U32)k_topic_subscribe, topic)
+ extern int __svc_indirect(0) _topic_subscribe(U32 p_func, int topic);
+
+ extern int k_topic_unsubscribe(int topic);
+ #define topic_unsubscribe(topic) _topic_unsubscribe((U32)k_topic_unsubscribe, topic)
+ extern int __svc_indirect(0) _topic_unsubscribe(U32 p_func, int topic);
+
+ extern int k_topic_publish(int topic, const void *buf, size_t len);
+ #define topic_publish(topic, buf, len) _topic_publish((U32)k_topic_publish, topic, buf, len)
+ extern int __svc_indirect(0) _topic_publish(U32 p_func, int topic, const void *buf, size_t len);
+
+ /* returns a read-only pointer to the shared sample, hand it back with topic_release */
+ extern const void *k_topic_recv(int topic, size_t *len);
+ #define topic_recv(topic, len) _topic_recv((U32)k_topic_recv, topic, len)
+ extern const void * __svc_indirect(0) _topic_recv(U32 p_func, int topic, size_t *len);
+
+ extern int k_topic_release(const void *sample);
+ #define topic_release(sample) _topic_release((U32)k_topic_release, sample)
+ extern int __svc_indirect(0) _topic_release(U32 p_func, const void *sample);
+
+ /*------------------------------------------------------------------------*
+  * Interrupt Functions
+  *------------------------------------------------------------------------*/
+
+ /* the handler runs in the IRQ handler, so only privileged tasks may register one */
+ extern int k_irq_register(U32 irq_id, IRQ_HANDLER handler, void *arg);
+ #define irq_register(irq_id, handler, arg) _irq_register((U32)k_irq_register, irq_id, handler, arg)
+ extern int __svc_indirect(0) _irq_register(U32 p_func, U32 irq_id, IRQ_HANDLER handler, void *arg);
+
+ extern int k_irq_get_stats(U32 irq_id, RTX_IRQ_STATS *buffer);
+ #define irq_get_stats(irq_id, buffer) _irq_get_stats((U32)k_irq_get_stats, irq_id, buffer)
+ extern int __svc_indirect(0) _irq_get_stats(U32 p_func, U32 irq_id, RTX_IRQ_STATS *buffer);
+
+ /* prints the interrupt and IRQs-off statistics on the JTAG UART */
+ extern int k_irq_dump_stats(void);
+ #define irq_dump_stats() _irq_dump_stats((U32)k_irq_dump_stats)
+ extern int __svc_indirect(0) _irq_dump_stats(U32 p_func);
+
+ /*------------------------------------------------------------------------*
+  * Event Trace Functions
+  *------------------------------------------------------------------------*/
+
+ /* fails unless the kernel is built with KTRACE, SVC 1 as it waits on the other CPUs */
+ extern int k_trace_ctl(int cmd);
+ #define trace_ctl(cmd) _trace_ctl((U32)k_trace_ctl, cmd)
+ extern int __svc_indirect(1) _trace_ctl(U32 p_func, int cmd);
+
+ /*------------------------------------------------------------------------*
+  * Profiler Functions
+  *------------------------------------------------------------------------*/
+
+ /* period_us is only used by PROF_START, SVC 1 so a dump does not hold the kernel lock */
+ extern int k_prof_ctl(int cmd, U32 period_us);
+ #define prof_ctl(cmd, period_us) _prof_ctl((U32)k_prof_ctl, cmd, period_us)
+ extern int __svc_indirect(1) _prof_ctl(U32 p_func, int cmd, U32 period_us);
+
+ /*------------------------------------------------------------------------*
+  * PMU Functions
+  *------------------------------------------------------------------------*/
+
+ /* count event on counter for the calling task only, its count restarts from 0 */
+ extern int k_pmu_select(U32 counter, U32 event);
+ #define pmu_select(counter, event) _pmu_select((U32)k_pmu_select, counter, event)
+ extern int __svc_indirect(0) _pmu_select(U32 p_func, U32 counter, U32 event);
+
+ extern int k_pmu_read(task_t tid, RTX_PMU_COUNTS *buf);
+ #define pmu_read(tid, buf) _pmu_read((U32)k_pmu_read, tid, buf)
+ extern int __svc_indirect(0) _pmu_read(U32 p_func, task_t tid, RTX_PMU_COUNTS *buf);
+
+ /*------------------------------------------------------------------------*
+  * Cache Functions
+  *------------------------------------------------------------------------*/
+
+ /* code written at run time may run on any CPU once this returns, SVC 1 as it waits on the other CPUs */
+ extern int k_cache_sync(void);
+ #define cache_sync() _cache_sync((U32)k_cache_sync)
+ extern int __svc_indirect(1) _cache_sync(U32 p_func);
+
+ /*------------------------------------------------------------------------*
+  * Task Notification Functions
+  *------------------------------------------------------------------------*/
+
+ extern int k_tsk_notify(task_t tid, U32 bits, int mode);
+ #define tsk_notify(tid, bits, mode) _tsk_notify((U32)k_tsk_notify, tid, bits, mode)
+ extern int __svc_indirect(0) _tsk_notify(U32 p_func, task_t tid, U32 bits, int mode);
+
+ /* returns the notification bits in mask that were set, 0 on timeout */
+ extern U32 k_tsk_wait_notify(U32 mask, int clear, U32 timeout_us);
+ #define tsk_wait_notify(mask, clear, timeout_us) _tsk_wait_notify((U32)k_tsk_wait_notify, mask, clear, timeout_us)
+ extern U32 __svc_indirect(0) _tsk_wait_notify(U32 p_func, U32 mask, int clear, U32 timeout_us);
+
+ /*------------------------------------------------------------------------*
+  * Task Affinity Functions
+  *------------------------------------------------------------------------*/
+
+ /* tsk_create with the ptask, prio, u_stack_size and affinity of info */
+ extern int k_tsk_create_ex(task_t *task, const RTX_TASK_INFO *info);
+ #define tsk_create_ex(task, info) _tsk_create_ex((U32)k_tsk_create_ex, task, info)
+ extern int __svc_indirect(0) _tsk_create_ex(U32 p_func, task_t *task, const RTX_TASK_INFO *info);
+
+ /* a running task that loses its CPU moves the next time it is switched out */
+ extern int k_tsk_set_affinity(task_t tid, U8 mask);
+ #define tsk_set_affinity(tid, mask) _tsk_set_affinity((U32)k_tsk_set_affinity, tid, mask)
+ extern int __svc_indirect(0) _tsk_set_affinity(U32 p_func, task_t tid, U8 mask);
+
+ /* returns the mask of CPUs the task may run on, RTX_ERR on failure */
+ extern int k_tsk_get_affinity(task_t tid);
+ #define tsk_get_affinity(tid) _tsk_get_affinity((U32)k_tsk_get_affinity, tid)
+ extern int __svc_indirect(0) _tsk_get_affinity(U32 p_func, task_t tid);
+
+ /*------------------------------------------------------------------------*
+  * Semaphore, Mutex and Resource Functions
+  *------------------------------------------------------------------------*/
+
+ extern int k_sem_create(int count);
+ #define sem_create(count) _sem_create((U32)k_sem_create, count)
+ extern int __svc_indirect(0) _sem_create(U32 p_func, int count);
+
+ extern int k_sem_wait(int sem);
+ #define sem_wait(sem) _sem_wait((U32)k_sem_wait, sem)
+ extern int __svc_indirect(0) _sem_wait(U32 p_func, int sem);
+
+ extern int k_sem_post(int sem);
+ #define sem_post(sem) _sem_post((U32)k_sem_post, sem)
+ extern int __svc_indirect(0) _sem_post(U32 p_func, int sem);
+
+ extern int k_mutex_create(void);
+ #define mutex_create() _mutex_create((U32)k_mutex_create)
+ extern int __svc_indirect(0) _mutex_create(U32 p_func);
+
+ /* the owner runs at the priority of its highest priority waiter until it unlocks */
+ extern int k_mutex_lock(int mutex);
+ #define mutex_lock(mutex) _mutex_lock((U32)k_mutex_lock, mutex)
+ extern int __svc_indirect(0) _mutex_lock(U32 p_func, int mutex);
+
+ extern int k_mutex_unlock(int mutex);
+ #define mutex_unlock(mutex) _mutex_unlock((U32)k_mutex_unlock, mutex)
+ extern int __svc_indirect(0) _mutex_unlock(U32 p_func, int mutex);
+
+ /* immediate priority ceiling: taking a resource raises the caller to its ceiling */
+ extern int k_res_create(U8 ceiling);
+ #define res_create(ceiling) _res_create((U32)k_res_create, ceiling)
+ extern int __svc_indirect(0) _res_create(U32 p_func, U8 ceiling);
+
+ extern int k_res_acquire(int res);
+ #define res_acquire(res) _res_acquire((U32)k_res_acquire, res)
+ extern int __svc_indirect(0) _res_acquire(U32 p_func, int res);
+
+ extern int k_res_release(int res);
+ #define res_release(res) _res_release((U32)k_res_release, res)
+ extern int __svc_indirect(0) _res_release(U32 p_func, int res);
+
+ /*------------------------------------------------------------------------*
+  * Software Timer Functions
+  *------------------------------------------------------------------------*/
+
+ /* period is rounded up to whole ticks of MIN_RTX_QTM us */
+ extern int k_timer_create(U32 period_us, int mode, const RTX_TIMER_ACTION *action);
+ #define timer_create(period_us, mode, action) _timer_create((U32)k_timer_create, period_us, mode, action)
+ extern int __svc_indirect(0) _timer_create(U32 p_func, U32 period_us, int mode, const RTX_TIMER_ACTION *action);
+
+ extern int k_timer_delete(int timer);
+ #define timer_delete(timer) _timer_delete((U32)k_timer_delete, timer)
+ extern int __svc_indirect(0) _timer_delete(U32 p_func, int timer);
+
+ /*------------------------------------------------------------------------*
+  * UART Functions
+  *------------------------------------------------------------------------*/
+
+ extern int k_uart_rx_recv(char *buf, size_t len);
+ #define uart_rx_recv(buf, len) _uart_rx_recv((U32)k_uart_rx_recv, buf, len)
+ extern int __svc_indirect(0) _uart_rx_recv(U32 p_func, char *buf, size_t len);
+
+ /* tasks print to the RTX console through this rather than DISPLAY messages */
+ extern int k_uart_tx_write(const char *buf, size_t len);
+ #define uart_tx_write(buf, len) _uart_tx_write((U32)k_uart_tx_write, buf, len)
+ extern int __svc_indirect(0) _uart_tx_write(U32 p_func, const char *buf, size_t len);
 
  /*
   *===========================================================================
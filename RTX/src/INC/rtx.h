@@ -52,6 +52,7 @@
  *===========================================================================
  */
 #define __SVC_0  __svc_indirect(0)
+#define __SVC_1  __svc_indirect(1)     /* no kernel lock, the kernel function takes what it needs */
 
 /*
  *===========================================================================
@@ -71,11 +72,11 @@ extern int _mem_init(U32 p_func) __SVC_0;
 
 extern void *k_mem_alloc(size_t size);
 #define mem_alloc(size) _mem_alloc((U32)k_mem_alloc, size)
-extern void *_mem_alloc(U32 p_func, size_t size) __SVC_0;
+extern void *_mem_alloc(U32 p_func, size_t size) __SVC_1;
 
 extern int k_mem_dealloc(void *);
 #define mem_dealloc(ptr) _mem_dealloc((U32)k_mem_dealloc, ptr)
-extern int _mem_dealloc(U32 p_func, void *ptr) __SVC_0;
+extern int _mem_dealloc(U32 p_func, void *ptr) __SVC_1;
 
 extern int k_mem_count_extfrag(size_t size);
 #define mem_count_extfrag(size) _mem_count_extfrag((U32)k_mem_count_extfrag, size)
@@ -105,7 +106,7 @@ extern int __SVC_0 _get_sys_info(U32 p_func, RTX_SYS_INFO *buffer);
 
 extern int k_tsk_yield(void);
 #define tsk_yield() _tsk_yield((U32)k_tsk_yield)
-extern int __SVC_0 _tsk_yield(U32 p_func);
+extern int __SVC_1 _tsk_yield(U32 p_func);
 
 extern int k_tsk_create(task_t *task, void (*task_entry)(void), U8 prio, U16 stack_size);
 #define tsk_create(task, task_entry, prio, stack_size) _tsk_create((U32)k_tsk_create, task, task_entry, prio, stack_size)
@@ -166,6 +166,198 @@ void ae_set_task_info(RTX_TASK_INFO *tasks, int num_tasks) {
 
 #endif
 
+#if TEST == 9
+
+    printf("============================================\r\n");
+    printf("============================================\r\n");
+    printf("Info: Starting T_09!\r\n");
+    printf("Info: Initializing system with an RPC server (H) and client (M)!\r\n");
+
+    tasks[0].prio = HIGH;
+	tasks[0].priv = 0;
+	tasks[0].ptask = &utask1;
+	tasks[0].k_stack_size = 0x200;
+	tasks[0].u_stack_size = 0x200;
+
+    tasks[1].prio = MEDIUM;
+	tasks[1].priv = 0;
+	tasks[1].ptask = &utask2;
+	tasks[1].k_stack_size = 0x200;
+	tasks[1].u_stack_size = 0x200;
+
+#endif
+
+#if TEST == 10
+
+    printf("============================================\r\n");
+    printf("============================================\r\n");
+    printf("Info: Starting T_10!\r\n");
+    printf("Info: Initializing system with a timer benchmark task (H)!\r\n");
+
+    tasks[0].prio = HIGH;
+	tasks[0].priv = 0;
+	tasks[0].ptask = &utask1;
+	tasks[0].k_stack_size = 0x200;
+	tasks[0].u_stack_size = 0x200;
+
+#endif
+
+#if TEST == 11
+
+    printf("============================================\r\n");
+    printf("============================================\r\n");
+    printf("Info: Starting T_11!\r\n");
+    printf("Info: Initializing system with a yield benchmark task (H)!\r\n");
+
+    tasks[0].prio = HIGH;
+	tasks[0].priv = 0;
+	tasks[0].ptask = &utask1;
+	tasks[0].k_stack_size = 0x200;
+	tasks[0].u_stack_size = 0x200;
+
+#endif
+
+#if TEST == 12
+
+    printf("============================================\r\n");
+    printf("============================================\r\n");
+    printf("Info: Starting T_12!\r\n");
+    printf("Info: Initializing system with a topic test task (H)!\r\n");
+
+    tasks[0].prio = HIGH;
+	tasks[0].priv = 0;
+	tasks[0].ptask = &utask1;
+	tasks[0].k_stack_size = 0x200;
+	tasks[0].u_stack_size = 0x200;
+
+#endif
+
+#if TEST == 13
+
+    printf("============================================\r\n");
+    printf("============================================\r\n");
+    printf("Info: Starting T_13!\r\n");
+    printf("Info: Initializing system with an IRQ wake-up test task (H) on CPU 0!\r\n");
+
+    tasks[0].prio = HIGH;
+	tasks[0].priv = 0;
+	tasks[0].ptask = &utask1;
+	tasks[0].k_stack_size = 0x200;
+	tasks[0].u_stack_size = 0x200;
+	tasks[0].affinity = AFFINITY_CPU(0);
+
+#endif
+
+#if TEST == 14
+
+    printf("============================================\r\n");
+    printf("============================================\r\n");
+    printf("Info: Starting T_14!\r\n");
+    printf("Info: Initializing system with a notification test task (H)!\r\n");
+
+    tasks[0].prio = HIGH;
+	tasks[0].priv = 0;
+	tasks[0].ptask = &utask1;
+	tasks[0].k_stack_size = 0x200;
+	tasks[0].u_stack_size = 0x200;
+
+#endif
+
+#if TEST == 15
+
+    printf("============================================\r\n");
+    printf("============================================\r\n");
+    printf("Info: Starting T_15!\r\n");
+    printf("Info: Initializing system with a ceiling resource test task (H) on CPU 0!\r\n");
+
+    tasks[0].prio = HIGH;
+	tasks[0].priv = 0;
+	tasks[0].ptask = &utask1;
+	tasks[0].k_stack_size = 0x200;
+	tasks[0].u_stack_size = 0x200;
+	tasks[0].affinity = AFFINITY_CPU(0);
+
+#endif
+
+#if TEST == 16
+
+    printf("============================================\r\n");
+    printf("============================================\r\n");
+    printf("Info: Starting T_16!\r\n");
+    printf("Info: Initializing system with a priority inheritance test task (H) on CPU 0!\r\n");
+
+    tasks[0].prio = HIGH;
+	tasks[0].priv = 0;
+	tasks[0].ptask = &utask1;
+	tasks[0].k_stack_size = 0x200;
+	tasks[0].u_stack_size = 0x200;
+	tasks[0].affinity = AFFINITY_CPU(0);
+
+#endif
+
+#if TEST == 17
+
+    printf("============================================\r\n");
+    printf("============================================\r\n");
+    printf("Info: Starting T_17!\r\n");
+    printf("Info: Initializing system with a cross-CPU preemption and cache sync test task (H) on CPU 0!\r\n");
+
+    tasks[0].prio = HIGH;
+	tasks[0].priv = 0;
+	tasks[0].ptask = &utask1;
+	tasks[0].k_stack_size = 0x200;
+	tasks[0].u_stack_size = 0x200;
+	tasks[0].affinity = AFFINITY_CPU(0);
+
+#endif
+
+#if TEST == 18
+
+    printf("============================================\r\n");
+    printf("============================================\r\n");
+    printf("Info: Starting T_18!\r\n");
+    printf("Info: Initializing system with a cross-CPU free test task (H)!\r\n");
+
+    tasks[0].prio = HIGH;
+	tasks[0].priv = 0;
+	tasks[0].ptask = &utask1;
+	tasks[0].k_stack_size = 0x200;
+	tasks[0].u_stack_size = 0x200;
+
+#endif
+
+#if TEST == 19
+
+    printf("============================================\r\n");
+    printf("============================================\r\n");
+    printf("Info: Starting T_19!\r\n");
+    printf("Info: Initializing system with a run time statistics test task (H) on CPU 0!\r\n");
+
+    tasks[0].prio = HIGH;
+	tasks[0].priv = 0;
+	tasks[0].ptask = &utask1;
+	tasks[0].k_stack_size = 0x200;
+	tasks[0].u_stack_size = 0x200;
+	tasks[0].affinity = AFFINITY_CPU(0);
+
+#endif
+
+#if TEST == 20
+
+    printf("============================================\r\n");
+    printf("============================================\r\n");
+    printf("Info: Starting T_20!\r\n");
+    printf("Info: Initializing system with a per-task PMU test task (H) on CPU 0!\r\n");
+
+    tasks[0].prio = HIGH;
+	tasks[0].priv = 0;
+	tasks[0].ptask = &utask1;
+	tasks[0].k_stack_size = 0x200;
+	tasks[0].u_stack_size = 0x200;
+	tasks[0].affinity = AFFINITY_CPU(0);
+
+#endif
+
 #if TEST == 8
 
 	printf("RUNNING\r\n");
@@ -71,6 +71,54 @@ extern task_t ktid3;
 #if TEST == 8
 	#define BOOT_TASKS 1
 #endif
+
+#if TEST == 9
+	#define BOOT_TASKS 2
+#endif
+
+#if TEST == 10
+	#define BOOT_TASKS 1
+#endif
+
+#if TEST == 11
+	#define BOOT_TASKS 1
+#endif
+
+#if TEST == 12
+	#define BOOT_TASKS 1
+#endif
+
+#if TEST == 13
+	#define BOOT_TASKS 1
+#endif
+
+#if TEST == 14
+	#define BOOT_TASKS 1
+#endif
+
+#if TEST == 15
+	#define BOOT_TASKS 1
+#endif
+
+#if TEST == 16
+	#define BOOT_TASKS 1
+#endif
+
+#if TEST == 17
+	#define BOOT_TASKS 1
+#endif
+
+#if TEST == 18
+	#define BOOT_TASKS 1
+#endif
+
+#if TEST == 19
+	#define BOOT_TASKS 1
+#endif
+
+#if TEST == 20
+	#define BOOT_TASKS 1
+#endif
 /*
  *===========================================================================
  *                            FUNCTION PROTOTYPES
@@ -38,6 +38,42 @@ task_t utid1;
 task_t utid2;
 task_t utid3;
 
+#if TEST >= 13
+
+/* cap on the busy loops of the spinning tasks, in loop iterations. Every
+   test stops its spinner long before, the cap only ends a spinner that a
+   failed test would leave running. */
+#define SPIN_LIMIT 200000000
+
+/**
+ * @brief: create fn at prio with a small user stack, limited to one CPU
+ */
+static __inline int create_on_cpu(task_t *tid, void (*fn)(void), U8 prio, int cpu)
+{
+	RTX_TASK_INFO info;
+
+	info.ptask = fn;
+	info.prio = prio;
+	info.u_stack_size = 0x200;
+	info.affinity = AFFINITY_CPU(cpu);
+	return tsk_create_ex(tid, &info);
+}
+
+static __inline U32 us_between(const TIMEVAL *start, const TIMEVAL *end)
+{
+	return (end->sec - start->sec) * 1000000U + end->usec - start->usec;
+}
+
+static __inline U32 elapsed_us(const TIMEVAL *start)
+{
+	TIMEVAL now;
+
+	get_time(&now);
+	return us_between(start, &now);
+}
+
+#endif
+
 #if TEST == 0
 void utask1(void)
 {
@@ -169,14 +205,14 @@ void utask1(void) {
 								for (j = 0; j < 4; j++) {
 									char c = *((char *)(msg + 1) + j);
 
-									SER_PutChar(1, c);
+									uart_tx_write(&c, 1);
 
 									if (c != message[j]) {
 										correct_msg = 0;
 									}
 								}
 
-								SER_PutStr(1, "\r\n");
+								uart_tx_write("\r\n", 2);
 							} else {
 								correct_msg = 0;
 							}
@@ -340,14 +376,14 @@ void utask2(void) {
 									for (j = 0; j < 4; j++) {
 										char c = *((char *)(msg + 1) + j);
 
-										SER_PutChar(1, c);
+										uart_tx_write(&c, 1);
 
 										if (c != message[j]) {
 											correct_msg = 0;
 										}
 									}
 
-									SER_PutStr(1, "\r\n");
+									uart_tx_write("\r\n", 2);
 								} else {
 									correct_msg = 0;
 								}
@@ -621,6 +657,995 @@ void utask2(void) {
 
 #endif
 
+#if TEST == 9
+
+#define RPC_ROUNDS 100
+
+/**
+ * @brief: RPC server, replies to each request with the upper case string
+ */
+void utask1(void) {
+	char req[8];
+	char reply[8];
+	task_t client_tid;
+	int len;
+
+	printf("[UT1] Info: Entering RPC server!\r\n");
+	utid1 = tsk_get_tid();
+
+	while (1) {
+		len = msg_receive(&client_tid, req, sizeof(req));
+		if (len == RTX_ERR) {
+			printf("[UT1] Failed: msg_receive returned an error!\r\n");
+			continue;
+		}
+		for (int i = 0; i < len; i++) {
+			reply[i] = (req[i] >= 'a' && req[i] <= 'z') ? req[i] - 'a' + 'A' : req[i];
+		}
+		if (msg_reply(client_tid, reply, len) != RTX_OK) {
+			printf("[UT1] Failed: msg_reply returned an error!\r\n");
+		}
+	}
+}
+
+/**
+ * @brief: RPC client, checks the replies and times the round trips
+ */
+void utask2(void) {
+	char req[4] = {'c', 'G', 't', 'a'};
+	char reply[8];
+	int eflag = 0;
+
+	printf("[UT2] Info: Entering RPC client!\r\n");
+	utid2 = tsk_get_tid();
+
+	// the server may still be starting on the other CPU
+	while (utid1 == 0) {
+		tsk_yield();
+	}
+
+	if (msg_call(utid2, req, sizeof(req), reply, sizeof(reply)) != RTX_ERR) {
+		printf("[UT2] Failed: msg_call to itself did not fail!\r\n");
+		eflag++;
+	}
+
+	if (msg_reply(utid1, reply, sizeof(reply)) != RTX_ERR) {
+		printf("[UT2] Failed: msg_reply to a task that is not waiting did not fail!\r\n");
+		eflag++;
+	}
+
+	if (msg_call(utid1, req, sizeof(req), NULL, sizeof(reply)) != RTX_ERR) {
+		printf("[UT2] Failed: msg_call without a reply buffer did not fail!\r\n");
+		eflag++;
+	}
+
+	unsigned int start = timer_get_current_val(2);
+	for (int i = 0; i < RPC_ROUNDS; i++) {
+		if (msg_call(utid1, req, sizeof(req), reply, sizeof(reply)) != sizeof(req) ||
+			reply[0] != 'C' || reply[1] != 'G' || reply[2] != 'T' || reply[3] != 'A') {
+			eflag++;
+			break;
+		}
+	}
+	unsigned int end = timer_get_current_val(2);
+
+	if (eflag == 0) {
+		printf("[UT2] Passed: %d round trips, %u us each!\r\n", RPC_ROUNDS, (start - end) / RPC_ROUNDS);
+	}
+
+	printf("============================================\r\n");
+	printf("=============Final test results=============\r\n");
+	printf("============================================\r\n");
+	printf("[T_09] %d out of 4 tests passed!\r\n", 4 - eflag);
+	tsk_exit();
+}
+
+#endif
+
+#if TEST == 10
+
+#define BENCH_TIMERS 1000
+#define BENCH_WAIT_US 500000
+
+static int g_bench_timers[BENCH_TIMERS];
+
+/**
+ * @brief: sleeps instead of spinning, so the timers' deferred work gets the CPU
+ */
+static void wait_us(U32 us)
+{
+	// nobody notifies us, this only waits out the window
+	tsk_wait_notify(0x1, 1, us);
+}
+
+/**
+ * @brief: arms 1000 periodic timers and compares the worst tick handler time
+ *         with the one seen before any timer was armed
+ */
+void utask1(void) {
+	RTX_TIMER_ACTION action;
+	RTX_IRQ_STATS idle;
+	RTX_IRQ_STATS busy;
+	int armed = 0;
+	int eflag = 0;
+
+	printf("[UT1] Info: Entering timer benchmark!\r\n");
+
+	// nobody subscribes, so each fire costs the tick and one empty publish
+	action.type = TIMER_TOPIC;
+	action.fn = NULL;
+	action.arg = NULL;
+	action.topic = topic_open("bench");
+
+	wait_us(BENCH_WAIT_US);
+	irq_get_stats(HPS_TIMER0_IRQ_ID, &idle);
+
+	for (int i = 0; i < BENCH_TIMERS; i++) {
+		// spread the periods over 1 to 97 ms so every wheel slot is populated
+		g_bench_timers[i] = timer_create((i % 97 + 1) * 1000, TIMER_PERIODIC, &action);
+		if (g_bench_timers[i] != RTX_ERR) {
+			armed++;
+		}
+	}
+	if (armed != BENCH_TIMERS) {
+		printf("[UT1] Failed: only %d of %d timers armed!\r\n", armed, BENCH_TIMERS);
+		eflag++;
+	}
+
+	wait_us(BENCH_WAIT_US);
+	irq_get_stats(HPS_TIMER0_IRQ_ID, &busy);
+	printf("[UT1] Info: tick handler max %u cycles idle, %u cycles with %d timers\r\n",
+	       idle.max_cycles, busy.max_cycles, armed);
+
+	for (int i = 0; i < BENCH_TIMERS; i++) {
+		if (g_bench_timers[i] != RTX_ERR && timer_delete(g_bench_timers[i]) != RTX_OK) {
+			eflag++;
+		}
+	}
+	if (timer_delete(g_bench_timers[0]) != RTX_ERR) {
+		printf("[UT1] Failed: deleting a timer twice did not fail!\r\n");
+		eflag++;
+	}
+
+	printf("============================================\r\n");
+	printf("=============Final test results=============\r\n");
+	printf("============================================\r\n");
+	printf("[T_10] %d out of 1 tests passed!\r\n", eflag == 0);
+	tsk_exit();
+}
+
+#endif
+
+#if TEST == 11
+
+#define YIELD_TASKS 64
+#define YIELD_WINDOW_US 1000000
+
+#ifdef RQ_GLOBAL
+#define RQ_MODE "one global ready queue"
+#else
+#define RQ_MODE "per-CPU ready queues"
+#endif
+
+static task_t g_yield_tids[YIELD_TASKS];
+static volatile U32 g_yields[YIELD_TASKS];
+static volatile int g_yield_stop = 0;
+
+/**
+ * @brief: counts its own yields until utask1 ends the run
+ */
+void yield_task(void) {
+	task_t tid = tsk_get_tid();
+	int slot = 0;
+
+	while (g_yield_tids[slot] != tid) {
+		slot++;
+	}
+	while (!g_yield_stop) {
+		g_yields[slot]++;
+		tsk_yield();
+	}
+	tsk_exit();
+}
+
+/**
+ * @brief: lets 64 equal priority tasks yield to each other for one second,
+ *         build with and without RQ_GLOBAL to compare the two schedulers
+ */
+void utask1(void) {
+	U32 total = 0;
+	int created = 0;
+	int starved = 0;
+	int passed = 0;
+
+	printf("[UT1] Info: Entering yield benchmark on %s!\r\n", RQ_MODE);
+
+	for (int i = 0; i < YIELD_TASKS; i++) {
+		if (tsk_create(&g_yield_tids[i], &yield_task, MEDIUM, 0x200) == RTX_OK) {
+			created++;
+		}
+	}
+	if (created == YIELD_TASKS) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: only %d of %d tasks created!\r\n", created, YIELD_TASKS);
+	}
+
+	// nobody notifies us, this only waits out the window
+	tsk_wait_notify(0x1, 1, YIELD_WINDOW_US);
+	for (int i = 0; i < YIELD_TASKS; i++) {
+		total += g_yields[i];
+		if (g_yields[i] == 0) {
+			starved++;
+		}
+	}
+	g_yield_stop = 1;
+
+	printf("[UT1] Info: %u yields in %u ms\r\n", total, YIELD_WINDOW_US / 1000);
+	if (starved == 0) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: %d tasks never ran!\r\n", starved);
+	}
+
+	printf("============================================\r\n");
+	printf("=============Final test results=============\r\n");
+	printf("============================================\r\n");
+	printf("[T_11] %d out of 2 tests passed!\r\n", passed);
+	tsk_exit();
+}
+
+#endif
+
+#if TEST == 12
+
+#define TOPIC_HEAP_ALL 0x7FFFFFFF       /* mem_count_extfrag counts every free block */
+
+static const void *g_topic_sample = NULL;
+static volatile int g_topic_foreign = RTX_OK;
+
+/**
+ * @brief: tries to release a sample it never received, then subscribes and
+ *         exits holding a sample
+ */
+void topic_helper(void) {
+	int topic = topic_open("t12");
+	size_t len;
+
+	g_topic_foreign = topic_release(g_topic_sample);
+	topic_subscribe(topic);
+	tsk_notify(utid1, 0x1, NOTIFY_SET_BITS);
+	topic_recv(topic, &len);
+	tsk_exit();
+}
+
+/**
+ * @brief: publish, receive and release, a release by a task that does not
+ *         hold the sample, and a subscriber that exits holding one
+ */
+void utask1(void) {
+	char data[4] = {'a', 'b', 'c', '\0'};
+	const char *sample;
+	const void *kept;
+	RTX_TASK_INFO info;
+	task_t helper;
+	size_t len = 0;
+	int topic;
+	int base;
+	int passed = 0;
+
+	printf("[UT1] Info: Entering topic test!\r\n");
+	utid1 = tsk_get_tid();
+	topic = topic_open("t12");
+	topic_subscribe(topic);
+
+	topic_publish(topic, data, sizeof(data));
+	sample = topic_recv(topic, &len);
+	if (sample != NULL && len == sizeof(data) && sample[0] == 'a' && sample[2] == 'c') {
+		passed++;
+	} else {
+		printf("[UT1] Failed: did not receive the published sample!\r\n");
+	}
+	if (topic_release(sample) == RTX_OK && topic_release(sample) == RTX_ERR) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: a sample could not be released exactly once!\r\n");
+	}
+	base = mem_count_extfrag(TOPIC_HEAP_ALL);
+
+	// the helper gets a sample it never received
+	topic_publish(topic, data, sizeof(data));
+	kept = topic_recv(topic, &len);
+	g_topic_sample = kept;
+	tsk_create(&helper, &topic_helper, LOW, 0x200);
+	tsk_wait_notify(0x1, 1, TIMEOUT_FOREVER);
+	if (g_topic_foreign == RTX_ERR && topic_release(kept) == RTX_OK) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: a task released a sample it did not hold!\r\n");
+	}
+
+	// both get this one, the helper exits without releasing its reference
+	if (topic_publish(topic, data, sizeof(data)) != 2) {
+		printf("[UT1] Failed: the sample did not reach both subscribers!\r\n");
+	}
+	topic_release(topic_recv(topic, &len));
+	while (tsk_get_info(helper, &info) == RTX_OK && info.state != DORMANT) {
+		tsk_wait_notify(0x2, 1, 1000);
+	}
+	if (mem_count_extfrag(TOPIC_HEAP_ALL) == base) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: the heap did not return to its baseline after the helper exited!\r\n");
+	}
+
+	printf("============================================\r\n");
+	printf("=============Final test results=============\r\n");
+	printf("============================================\r\n");
+	printf("[T_12] %d out of 4 tests passed!\r\n", passed);
+	tsk_exit();
+}
+
+#endif
+
+#if TEST == 13
+
+#define WAKE_US 10000                   /* how long utask1 sleeps */
+#define WAKE_SLACK_US 5000              /* a tick and the switch, with room to spare */
+
+static volatile U32 g_spins = 0;
+static volatile int g_spin_stop = 0;
+
+/**
+ * @brief: spins without a syscall, so only an interrupt can take CPU 0 back
+ */
+void spin_task(void) {
+	while (!g_spin_stop && g_spins < SPIN_LIMIT) {
+		g_spins++;
+	}
+	tsk_exit();
+}
+
+/**
+ * @brief: sleeps on CPU 0 while a low priority task spins there, and checks
+ *         the timeout interrupt hands the CPU back in time
+ */
+void utask1(void) {
+	task_t spinner;
+	TIMEVAL start;
+	U32 slept;
+	int passed = 0;
+
+	printf("[UT1] Info: Entering IRQ wake-up test!\r\n");
+
+	if (create_on_cpu(&spinner, &spin_task, LOW, 0) == RTX_OK) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: could not create the spinner!\r\n");
+	}
+
+	// nobody notifies us, the timeout interrupt has to wake us
+	get_time(&start);
+	tsk_wait_notify(0x1, 1, WAKE_US);
+	slept = elapsed_us(&start);
+	g_spin_stop = 1;
+
+	printf("[UT1] Info: woke after %u us, the spinner ran %u loops\r\n", slept, g_spins);
+	if (g_spins > 0 && g_spins < SPIN_LIMIT && slept < WAKE_US + WAKE_SLACK_US) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: the interrupt did not preempt the spinner!\r\n");
+	}
+
+	printf("============================================\r\n");
+	printf("=============Final test results=============\r\n");
+	printf("============================================\r\n");
+	printf("[T_13] %d out of 2 tests passed!\r\n", passed);
+	tsk_exit();
+}
+
+#endif
+
+#if TEST == 14
+
+#define NOTIFY_WAIT_US 20000            /* timeout nobody notifies within */
+#define NOTIFY_SLACK_US 5000            /* a tick and the switch, with room to spare */
+
+/**
+ * @brief: notifies utask1 once it is waiting
+ */
+void notify_helper(void) {
+	tsk_notify(utid1, 0x4, NOTIFY_SET_BITS);
+	tsk_exit();
+}
+
+/**
+ * @brief: a pending notification, a wait that times out and a wait that a
+ *         lower priority task ends before its timeout
+ */
+void utask1(void) {
+	task_t helper;
+	TIMEVAL start;
+	U32 waited;
+	int passed = 0;
+
+	printf("[UT1] Info: Entering notification test!\r\n");
+	utid1 = tsk_get_tid();
+
+	// set before the wait, returned at once and cleared
+	tsk_notify(utid1, 0x8, NOTIFY_SET_BITS);
+	if (tsk_wait_notify(0x8, 1, 0) == 0x8 && tsk_wait_notify(0x8, 1, 0) == 0) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: a pending notification was not returned and cleared!\r\n");
+	}
+
+	get_time(&start);
+	if (tsk_wait_notify(0x1, 1, NOTIFY_WAIT_US) == 0 && elapsed_us(&start) >= NOTIFY_WAIT_US) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: the wait did not time out after %u us!\r\n", NOTIFY_WAIT_US);
+	}
+
+	// the helper can only run once we block
+	tsk_create(&helper, &notify_helper, LOW, 0x200);
+	get_time(&start);
+	if (tsk_wait_notify(0x4, 1, NOTIFY_WAIT_US) == 0x4) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: the notification was not delivered!\r\n");
+	}
+	waited = elapsed_us(&start);
+	if (waited < NOTIFY_WAIT_US - NOTIFY_SLACK_US) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: the notification took %u us to arrive!\r\n", waited);
+	}
+
+	printf("============================================\r\n");
+	printf("=============Final test results=============\r\n");
+	printf("============================================\r\n");
+	printf("[T_14] %d out of 4 tests passed!\r\n", passed);
+	tsk_exit();
+}
+
+#endif
+
+#if TEST == 15
+
+static volatile int g_res_med_ran = 0;
+
+/**
+ * @brief: only runs once utask1 drops below MEDIUM
+ */
+void res_med_task(void) {
+	g_res_med_ran = 1;
+	tsk_exit();
+}
+
+/**
+ * @brief: ceiling resource ids, the ceiling raising a LOW holder above a
+ *         ready MEDIUM task, the holder kept on the CPU of the resource,
+ *         and the release letting that task in
+ */
+void utask1(void) {
+	RTX_TASK_INFO info;
+	task_t med;
+	int res;
+	int passed = 0;
+
+	printf("[UT1] Info: Entering ceiling resource test!\r\n");
+	utid1 = tsk_get_tid();
+
+	res = res_create(MEDIUM);
+	if (res != RTX_ERR && res_create(PRIO_KERNEL) == RTX_ERR) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: res_create did not check the ceiling!\r\n");
+	}
+	if (res_release(-1) == RTX_ERR && res_release(0x7FFF) == RTX_ERR && res_release(res) == RTX_ERR) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: released a resource that is invalid or not held!\r\n");
+	}
+	if (res_acquire(res) == RTX_ERR) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: took a resource while running above its ceiling!\r\n");
+		res_release(res);
+	}
+
+	tsk_set_prio(utid1, LOW);
+	res_acquire(res);
+	tsk_get_info(utid1, &info);
+	if (info.prio == MEDIUM) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: the holder runs at %u, not at the ceiling!\r\n", info.prio);
+	}
+	if (tsk_set_affinity(utid1, AFFINITY_ANY) == RTX_ERR && tsk_get_affinity(utid1) == AFFINITY_CPU(0)) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: the holder could leave the CPU of the resource!\r\n");
+	}
+
+	// the MEDIUM task shares CPU 0 with us and must wait for the release
+	info.ptask = &res_med_task;
+	info.prio = MEDIUM;
+	info.u_stack_size = 0x200;
+	info.affinity = AFFINITY_CPU(0);
+	tsk_create_ex(&med, &info);         // would switch to it here if it outranked us
+	if (g_res_med_ran == 0) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: a MEDIUM task ran while the resource was held!\r\n");
+	}
+	if (res_release(res) == RTX_OK && g_res_med_ran == 1 && res_release(res) == RTX_ERR) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: the release did not let the MEDIUM task in!\r\n");
+	}
+
+	printf("============================================\r\n");
+	printf("=============Final test results=============\r\n");
+	printf("============================================\r\n");
+	printf("[T_15] %d out of 7 tests passed!\r\n", passed);
+	tsk_exit();
+}
+
+#endif
+
+#if TEST == 16
+
+#define PI_BLOCK_US 5000                /* HIGH waits for LOW's short section, never for MEDIUM */
+
+static int g_pi_mutex;
+static volatile U8 g_pi_held_prio = 0;
+static volatile U8 g_pi_after_prio = 0;
+static volatile U32 g_pi_spins = 0;
+static volatile int g_pi_stop = 0;
+
+static U8 my_prio(void)
+{
+	RTX_TASK_INFO info;
+
+	tsk_get_info(tsk_get_tid(), &info);
+	return info.prio;
+}
+
+/**
+ * @brief: takes the mutex, lets utask1 block on it, and records the
+ *         priority it holds it at
+ */
+void pi_low_task(void) {
+	mutex_lock(g_pi_mutex);
+	tsk_notify(utid1, 0x1, NOTIFY_SET_BITS);
+	g_pi_held_prio = my_prio();
+	mutex_unlock(g_pi_mutex);
+	g_pi_after_prio = my_prio();
+	tsk_notify(utid1, 0x2, NOTIFY_SET_BITS);
+	tsk_exit();
+}
+
+/**
+ * @brief: spins without a syscall, starving LOW unless LOW inherits
+ */
+void pi_med_task(void) {
+	while (!g_pi_stop && g_pi_spins < SPIN_LIMIT) {
+		g_pi_spins++;
+	}
+	tsk_exit();
+}
+
+/**
+ * @brief: LOW holds a mutex HIGH blocks on while MEDIUM is ready, all on
+ *         CPU 0. LOW has to inherit HIGH for HIGH to get the mutex soon.
+ */
+void utask1(void) {
+	task_t low;
+	task_t med;
+	TIMEVAL start;
+	U32 blocked;
+	int passed = 0;
+
+	printf("[UT1] Info: Entering priority inheritance test!\r\n");
+	utid1 = tsk_get_tid();
+	g_pi_mutex = mutex_create();
+
+	create_on_cpu(&low, &pi_low_task, LOW, 0);
+	tsk_wait_notify(0x1, 1, TIMEOUT_FOREVER);      // LOW holds the mutex now
+	create_on_cpu(&med, &pi_med_task, MEDIUM, 0);
+
+	get_time(&start);
+	mutex_lock(g_pi_mutex);
+	blocked = elapsed_us(&start);
+	g_pi_stop = 1;
+	mutex_unlock(g_pi_mutex);
+	tsk_wait_notify(0x2, 1, TIMEOUT_FOREVER);      // LOW runs again once MEDIUM stops
+
+	printf("[UT1] Info: blocked %u us, LOW held the mutex at %u\r\n", blocked, g_pi_held_prio);
+	if (g_pi_held_prio == HIGH) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: LOW did not inherit HIGH!\r\n");
+	}
+	if (g_pi_after_prio == LOW) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: LOW kept %u after unlocking!\r\n", g_pi_after_prio);
+	}
+	if (blocked < PI_BLOCK_US) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: HIGH waited behind MEDIUM!\r\n");
+	}
+
+	printf("============================================\r\n");
+	printf("=============Final test results=============\r\n");
+	printf("============================================\r\n");
+	printf("[T_16] %d out of 3 tests passed!\r\n", passed);
+	tsk_exit();
+}
+
+#endif
+
+#if TEST == 17
+
+#define XC_WAKE_US 5000                 /* an IPI and a switch, with room to spare */
+
+#define XC_MOV_R0(imm) (0xE3A00000 | (imm))    /* ARM MOV R0, #imm for imm < 256 */
+#define XC_BX_LR 0xE12FFF1E                     /* ARM BX LR */
+
+typedef U32 (*XC_CODE_FN)(void);
+
+static volatile U32 g_xc_spins = 0;
+static volatile int g_xc_stop = 0;
+static TIMEVAL g_xc_ran;
+static U32 g_xc_code[2];                        // a function patched at run time
+static volatile U32 g_xc_code_ret[2];
+
+/**
+ * @brief: spins on CPU 1 without a syscall, only an IPI can take it back
+ */
+void xc_low_task(void) {
+	while (!g_xc_stop && g_xc_spins < SPIN_LIMIT) {
+		g_xc_spins++;
+	}
+	tsk_exit();
+}
+
+/**
+ * @brief: made ready by utask1 on CPU 0, runs on CPU 1
+ */
+void xc_med_task(void) {
+	get_time(&g_xc_ran);
+	tsk_notify(utid1, 0x1, NOTIFY_SET_BITS);
+	tsk_exit();
+}
+
+/**
+ * @brief: runs the patched function on CPU 1 before and after utask1
+ *         patches it again on CPU 0
+ */
+void xc_code_task(void) {
+	g_xc_code_ret[0] = ((XC_CODE_FN)g_xc_code)();
+	tsk_notify(utid1, 0x4, NOTIFY_SET_BITS);
+	tsk_wait_notify(0x1, 1, TIMEOUT_FOREVER);
+	g_xc_code_ret[1] = ((XC_CODE_FN)g_xc_code)();
+	tsk_notify(utid1, 0x4, NOTIFY_SET_BITS);
+	tsk_exit();
+}
+
+/**
+ * @brief: a MEDIUM task created on CPU 0 for CPU 1 preempts the LOW task
+ *         spinning there, and code patched on CPU 0 runs on CPU 1 once
+ *         cache_sync returns
+ */
+void utask1(void) {
+	task_t low;
+	task_t med;
+	task_t code;
+	TIMEVAL start;
+	U32 latency;
+	int passed = 0;
+
+	printf("[UT1] Info: Entering cross-CPU preemption test!\r\n");
+	utid1 = tsk_get_tid();
+
+	create_on_cpu(&low, &xc_low_task, LOW, 1);
+	while (g_xc_spins == 0) {
+		tsk_wait_notify(0x2, 1, 1000);
+	}
+
+	get_time(&start);
+	create_on_cpu(&med, &xc_med_task, MEDIUM, 1);
+	if (tsk_wait_notify(0x1, 1, 10 * XC_WAKE_US) == 0x1) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: the MEDIUM task never ran on CPU 1!\r\n");
+	}
+	latency = us_between(&start, &g_xc_ran);
+	g_xc_stop = 1;
+
+	printf("[UT1] Info: MEDIUM ran %u us after it was made ready, LOW spun %u loops\r\n", latency, g_xc_spins);
+	if (latency < XC_WAKE_US && g_xc_spins < SPIN_LIMIT) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: CPU 1 did not switch to MEDIUM right away!\r\n");
+	}
+
+	// CPU 1 runs the function once, then again after it is patched here
+	g_xc_code[0] = XC_MOV_R0(0x5A);
+	g_xc_code[1] = XC_BX_LR;
+	cache_sync();
+	create_on_cpu(&code, &xc_code_task, MEDIUM, 1);
+	tsk_wait_notify(0x4, 1, 10 * XC_WAKE_US);
+	g_xc_code[0] = XC_MOV_R0(0xA5);
+	if (cache_sync() == RTX_OK && ((XC_CODE_FN)g_xc_code)() == 0xA5) {
+		tsk_notify(code, 0x1, NOTIFY_SET_BITS);
+		tsk_wait_notify(0x4, 1, 10 * XC_WAKE_US);
+	}
+	if (g_xc_code_ret[0] == 0x5A && g_xc_code_ret[1] == 0xA5) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: CPU 1 ran 0x%x then 0x%x, not the patched code!\r\n", g_xc_code_ret[0], g_xc_code_ret[1]);
+	}
+
+	printf("============================================\r\n");
+	printf("=============Final test results=============\r\n");
+	printf("============================================\r\n");
+	printf("[T_17] %d out of 3 tests passed!\r\n", passed);
+	tsk_exit();
+}
+
+#endif
+
+#if TEST == 18
+
+#define XC_BLOCKS 32                    /* more than a magazine holds, so the depot is used too */
+#define XC_HEAP_ALL 0x7FFFFFFF          /* mem_count_extfrag counts every free block */
+
+static void *g_xc_blocks[XC_BLOCKS];
+
+/**
+ * @brief: moves the caller to cpu, it gets there the next time it blocks
+ */
+static void move_to(int cpu)
+{
+	tsk_set_affinity(tsk_get_tid(), AFFINITY_CPU(cpu));
+	tsk_wait_notify(0x1, 1, 1000);
+}
+
+/**
+ * @brief: allocates magazine sized blocks on one CPU and frees them on the
+ *         other, the caches of both have to hand them back to the heap
+ * @return the number of blocks that could not be allocated or freed
+ */
+static int alloc_here_free_there(int from, int to)
+{
+	int failed = 0;
+
+	move_to(from);
+	for (int i = 0; i < XC_BLOCKS; i++) {
+		// 8 to 120 bytes, one size for each magazine class
+		g_xc_blocks[i] = mem_alloc((16 << (i % 4)) - 8);
+		if (g_xc_blocks[i] == NULL) {
+			failed++;
+		}
+	}
+	move_to(to);
+	for (int i = 0; i < XC_BLOCKS; i++) {
+		if (g_xc_blocks[i] != NULL && mem_dealloc(g_xc_blocks[i]) != RTX_OK) {
+			failed++;
+		}
+	}
+	return failed;
+}
+
+/**
+ * @brief: small blocks freed on the other CPU find their way back, and the
+ *         free heap is the same as before once both directions are done
+ */
+void utask1(void) {
+	int base;
+	int passed = 0;
+
+	printf("[UT1] Info: Entering cross-CPU free test!\r\n");
+
+	base = mem_count_extfrag(XC_HEAP_ALL);
+	if (alloc_here_free_there(0, 1) == 0) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: blocks taken on CPU 0 could not be freed on CPU 1!\r\n");
+	}
+	if (mem_count_extfrag(XC_HEAP_ALL) == base) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: the heap did not return to its baseline after CPU 0 to 1!\r\n");
+	}
+	if (alloc_here_free_there(1, 0) == 0) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: blocks taken on CPU 1 could not be freed on CPU 0!\r\n");
+	}
+	if (mem_count_extfrag(XC_HEAP_ALL) == base) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: the heap did not return to its baseline after CPU 1 to 0!\r\n");
+	}
+
+	printf("============================================\r\n");
+	printf("=============Final test results=============\r\n");
+	printf("============================================\r\n");
+	printf("[T_18] %d out of 4 tests passed!\r\n", passed);
+	tsk_exit();
+}
+
+#endif
+
+#if TEST == 19
+
+#define RT_SAMPLES 5
+#define RT_SAMPLE_US 10000              /* between two readings */
+
+static RTX_TASK_INFO g_rt_busy[RT_SAMPLES];     // too big for the user stack
+static RTX_TASK_INFO g_rt_self[RT_SAMPLES];
+static volatile int g_rt_stop = 0;
+
+/**
+ * @brief: keeps CPU 1 busy until utask1 is done reading its counters
+ */
+void rt_busy_task(void) {
+	volatile U32 spins = 0;
+
+	while (!g_rt_stop) {
+		spins++;
+	}
+	tsk_exit();
+}
+
+/**
+ * @brief: reads the run time statistics of a busy task on the other CPU
+ *         and of itself, they only ever grow and the busy task's keeps up
+ *         with the clock
+ */
+void utask1(void) {
+	RTX_TASK_INFO *busy = g_rt_busy;
+	RTX_TASK_INFO *self = g_rt_self;
+	task_t tid;
+	int grows = 1;
+	U64 window;
+	int passed = 0;
+
+	printf("[UT1] Info: Entering run time statistics test!\r\n");
+
+	create_on_cpu(&tid, &rt_busy_task, LOW, 1);
+
+	for (int i = 0; i < RT_SAMPLES; i++) {
+		// nobody notifies us, this only waits between readings
+		tsk_wait_notify(0x1, 1, RT_SAMPLE_US);
+		tsk_get_info(tid, &busy[i]);
+		tsk_get_info(tsk_get_tid(), &self[i]);
+	}
+	g_rt_stop = 1;
+
+	if (busy[0].run_time_us > 0 && self[0].run_time_us > 0) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: a task that ran reads no run time!\r\n");
+	}
+	for (int i = 1; i < RT_SAMPLES; i++) {
+		if (busy[i].run_time_us <= busy[i - 1].run_time_us || self[i].run_time_us < self[i - 1].run_time_us ||
+		    self[i].nvcsw <= self[i - 1].nvcsw) {
+			grows = 0;
+		}
+	}
+	if (grows) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: the run time or switch counts went backwards!\r\n");
+	}
+
+	// alone on CPU 1, the busy task runs for most of every window
+	window = busy[RT_SAMPLES - 1].run_time_us - busy[0].run_time_us;
+	printf("[UT1] Info: busy task ran %u us of %u us\r\n", (U32)window, (RT_SAMPLES - 1) * RT_SAMPLE_US);
+	if (window > (RT_SAMPLES - 1) * RT_SAMPLE_US / 2) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: the busy task's run time fell behind the clock!\r\n");
+	}
+
+	printf("============================================\r\n");
+	printf("=============Final test results=============\r\n");
+	printf("============================================\r\n");
+	printf("[T_19] %d out of 3 tests passed!\r\n", passed);
+	tsk_exit();
+}
+
+#endif
+
+#if TEST == 20
+
+#define PMU_ROUNDS 10
+#define PMU_WORK 20000                  /* loops task A runs per round, task B runs four times as many */
+
+static RTX_PMU_COUNTS g_pmu_counts[2];
+static volatile int g_pmu_selected[2];
+
+/**
+ * @brief: counts its own instructions while it takes turns with the other
+ *         worker on CPU 0, then hands its counts to utask1
+ */
+static void pmu_worker(int idx, U32 work) {
+	g_pmu_selected[idx] = (pmu_select(0, PMU_EV_INSTR) == RTX_OK);
+	for (int round = 0; round < PMU_ROUNDS; round++) {
+		for (volatile U32 i = 0; i < work; i++) {
+			;
+		}
+		tsk_yield();
+	}
+	pmu_read(tsk_get_tid(), &g_pmu_counts[idx]);
+	tsk_notify(utid1, 1 << idx, NOTIFY_SET_BITS);
+	tsk_exit();
+}
+
+void pmu_task_a(void) {
+	pmu_worker(0, PMU_WORK);
+}
+
+void pmu_task_b(void) {
+	pmu_worker(1, 4 * PMU_WORK);
+}
+
+/**
+ * @brief: two tasks alternate on CPU 0, B doing four times the work of A.
+ *         If the counters followed the CPU rather than the task both
+ *         would read about the same.
+ */
+void utask1(void) {
+	task_t a;
+	task_t b;
+	U32 done = 0;
+	int passed = 0;
+
+	printf("[UT1] Info: Entering per-task PMU test!\r\n");
+	utid1 = tsk_get_tid();
+
+	create_on_cpu(&a, &pmu_task_a, MEDIUM, 0);
+	create_on_cpu(&b, &pmu_task_b, MEDIUM, 0);
+	while (done != 0x3) {
+		done |= tsk_wait_notify(0x3, 1, TIMEOUT_FOREVER);
+	}
+
+	printf("[UT1] Info: A ran %u instructions in %u cycles, B %u in %u\r\n",
+	       (U32)g_pmu_counts[0].count[0], (U32)g_pmu_counts[0].cycles,
+	       (U32)g_pmu_counts[1].count[0], (U32)g_pmu_counts[1].cycles);
+	if (g_pmu_selected[0] && g_pmu_selected[1] &&
+	    g_pmu_counts[0].event[0] == PMU_EV_INSTR && g_pmu_counts[1].event[0] == PMU_EV_INSTR) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: the instruction counter could not be selected!\r\n");
+	}
+	if (g_pmu_counts[0].count[0] > 0 && g_pmu_counts[1].count[0] > 2 * g_pmu_counts[0].count[0]) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: a task was counted the other's instructions!\r\n");
+	}
+	if (g_pmu_counts[0].cycles > 0 && g_pmu_counts[1].cycles > 2 * g_pmu_counts[0].cycles) {
+		passed++;
+	} else {
+		printf("[UT1] Failed: a task was counted the other's cycles!\r\n");
+	}
+
+	printf("============================================\r\n");
+	printf("=============Final test results=============\r\n");
+	printf("============================================\r\n");
+	printf("[T_20] %d out of 3 tests passed!\r\n", passed);
+	tsk_exit();
+}
+
+#endif
+
 /*
  *===========================================================================
  *                             END OF FILE
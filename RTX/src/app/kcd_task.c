@@ -1,6 +1,19 @@
 /* The KCD Task Template File */
 
+#include "rtx.h"
+
+#define KCD_RX_CHUNK    16      /* characters taken from the UART RX ring per call */
+
 void kcd_task(void)
 {
-    /* not implemented yet */
+    char buf[KCD_RX_CHUNK];
+
+    /* keyboard input arrives through the UART RX ring rather than KEY_IN messages */
+    while (1) {
+        int n = uart_rx_recv(buf, sizeof(buf));
+        if (n > 0) {
+            uart_tx_write(buf, n);      // display back
+        }
+        /* command registration and dispatch are not implemented yet */
+    }
 }
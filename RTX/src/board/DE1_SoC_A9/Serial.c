@@ -37,7 +37,6 @@
 
 #include "../DE1_SoC_A9/Serial.h"
 
-
 /*----------------------------------------------------------------------------
   Write String to Serial Port
  *----------------------------------------------------------------------------*/
@@ -45,6 +44,14 @@ int SER_PutStr(int n, char *s)
 {
   if (s == NULL)
     return 1;
+  if (n == 1) {         /* queue the whole string in one go */
+    int len = 0;
+    while (s[len] != 0) {
+      len++;
+    }
+    UART0_TxWrite(s, len);
+    return 0;
+  }
   while (*s !=0) {      /* loop through each char in the string */
     SER_PutChar(n, *s++);/* print the char, then ptr increments  */
   }
@@ -106,10 +113,30 @@ void UART0_SetBaudRate(uint32_t baud_rate)
  *----------------------------------------------------------------------------*/
 void UART0_PutChar(char c)
 {
-  while ((UART0->UARTLSR & 0x20) == 0 || (UART0->UARTLSR & 0x40) == 0);   // Wait for UART TX to become free
+  UART0_TxWrite(&c, 1);
+}
+
+/*----------------------------------------------------------------------------
+  Characters the UART0 TX FIFO takes right now, see board/common/uart_tx.c
+ *----------------------------------------------------------------------------*/
+uint32_t UART0_GetTxRoom(void)
+{
+  return (UART0->UARTLSR & 0x20) ? UART0_FIFO_DEPTH : 0;  // THR empty, the whole FIFO is free
+}
+
+void UART0_PutTxData(char c)
+{
   UART0->UARTDR = c;
 }
 
+void UART0_SetTxIRQ(int enable)
+{
+  if (enable) {
+    UART0->UARTIER_DLH |= 0x2;                        // THR empty interrupt
+  } else {
+    UART0->UARTIER_DLH &= ~0x2;
+  }
+}
 
 /*----------------------------------------------------------------------------
   Read character from UART0 (PuTTY) (blocking read)
@@ -201,3 +228,8 @@ char UART0_GetRxData(void)
 {
 	return UART0->UARTDR & 0xFF;
 }
+
+int UART0_GetIRQType(void)
+{
+	return UART0->UART_IIR_FCR & 0xF;	// reading IIR also clears a THR empty interrupt
+}
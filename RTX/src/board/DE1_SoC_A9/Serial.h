@@ -74,6 +74,15 @@ typedef struct {
 
 #define UART0_CLK                       100000000 // L4_SP = 100MHz
 
+#define UART0_FIFO_DEPTH                64        // TX FIFO bytes written per THR empty interrupt
+#define UART0_TX_BUF_SIZE               1024      // TX ring size in bytes, power of 2
+
+/* UART0 interrupt identification (UART_IIR_FCR bits 3:0) */
+#define UART0_IIR_NONE                  0x1
+#define UART0_IIR_TX_EMPTY              0x2
+#define UART0_IIR_RX_DATA               0x4
+#define UART0_IIR_RX_TIMEOUT            0xC
+
 /* ECE350 START */
 #define BIT(X)                          ( 1 << (X) )
 #define NULL                            0
@@ -94,6 +103,15 @@ char JTAG_UART_GetChar(void);
 extern int UART0_GetRxIRQStatus(void);
 extern int UART0_GetRxDataStatus(void);
 extern char UART0_GetRxData(void);
+extern int UART0_GetIRQType(void);
+
+extern uint32_t UART0_GetTxRoom(void);
+extern void UART0_PutTxData(char c);
+extern void UART0_SetTxIRQ(int enable);
+
+/* TX ring, board/common/uart_tx.c */
+extern int UART0_TxWrite(const char *s, int len);
+extern void UART0_TxIRQ(void);
 
 extern void putc(void *p, char c);     /* call back function for printf, use JTAG UART */
 
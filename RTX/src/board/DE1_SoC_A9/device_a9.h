@@ -32,6 +32,7 @@
 #define STACK_SZ        0x00000200      				// 512 B stack for each mode
 #define RAM_START       0x00100000						// The DE1 SoC RAM start
 #define RAM_END         0x3FFFFFFF					   	// The DE1 RAM END
+#define NUM_CPUS        2								// Cortex-A9 MPCore cores in the HPS
 
 #endif
 /*
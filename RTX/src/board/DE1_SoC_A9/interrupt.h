@@ -45,6 +45,21 @@
 #define	UART0_Rx_IRQ_ID 194
 #define	HPS_TIMER0_IRQ_ID 199
 #define	HPS_TIMER1_IRQ_ID 200
+#define	IPI_SGI_ID 0			/* SGI the cores interrupt each other with */
+
+/* GIC priorities, a lower value preempts a higher one. The HPS GIC keeps the
+   top 5 bits, so levels are 8 apart. Keep the tick above the UART, and
+   IPIs above the tick so a reschedule request does not wait behind it.
+   HPS timer 1 drives the profiler, above everything so it samples the
+   other handlers too. */
+#define	HPS_TIMER1_IRQ_PRIO 0x30
+#define	IPI_IRQ_PRIO 0x38
+#define	HPS_TIMER0_IRQ_PRIO 0x40
+#define	A9_TIMER_IRQ_PRIO 0x60
+#define	UART0_IRQ_PRIO 0xA0
+#define	GIC_PRIO_MASK_NONE 0xFF
+#define	GIC_PRIO_IMPL_BITS 0xF8	/* priority bits the GIC keeps, the others read back as 0 */
+#define	GIC_PRIO_MASK_IS_NONE(pmr) (((pmr) & GIC_PRIO_IMPL_BITS) == GIC_PRIO_IMPL_BITS)
 
 #define __IM     volatile const      /* Defines 'read only' structure member permissions */
 #define __OM     volatile            /* Defines 'write only' structure member permissions */
@@ -60,6 +75,9 @@ void GIC_EndInterrupt(uint32_t);
 uint32_t GIC_AckPending(void);
 void GIC_SetBinaryPoint(uint32_t);
 void GIC_SetInterfacePriorityMask(uint32_t);
+uint32_t GIC_GetInterfacePriorityMask(void);
+uint32_t GIC_RaisePriorityMask(uint32_t);
+void GIC_SendSGI(uint32_t, uint32_t);
 void GIC_SetTarget(uint32_t, uint32_t);
 void GIC_SetConfiguration(uint32_t, uint32_t);
 uint32_t GIC_GetPriority(uint32_t);
@@ -30,20 +30,24 @@
 #include "../DE1_SoC_A9/Serial.h"
 #include "../DE1_SoC_A9/timer.h"
 
-// statically allocated initial stacks except for SVC mode
-U32 g_stacks[NUM_PRIV_MODES - 1][STACK_SZ >> 2];
+// statically allocated initial stacks except for SVC mode, one set per core
+U32 g_stacks[NUM_CPUS][NUM_PRIV_MODES - 1][STACK_SZ >> 2];
+
+#define SYSMGR_CPU1STARTADDR    (*(volatile U32 *)0xFFD080C4)   // where the boot ROM starts CPU 1
+#define RSTMGR_MPUMODRST        (*(volatile U32 *)0xFFD05010)   // bit n holds CPU n in reset
 
 /**************************************************************************//**
  * @brief		Set up stacks for each privileged mode except for SVC mode
  * @see			startup_a9.s Reset_Handler
  *****************************************************************************/
 void StackInit(void) {
+	U32 (*stacks)[STACK_SZ >> 2] = g_stacks[k_cpu_id()];
 	int i = 0;
-	__set_SP_MODE((U32) (g_stacks[++i]), INIT_MODE_SYS);
-	__set_SP_MODE((U32) (g_stacks[++i]), INIT_MODE_IRQ);
-	__set_SP_MODE((U32) (g_stacks[++i]), INIT_MODE_FIQ);
-	__set_SP_MODE((U32) (g_stacks[++i]), INIT_MODE_ABT);
-	__set_SP_MODE((U32) (g_stacks[++i]), INIT_MODE_UND);
+	__set_SP_MODE((U32) (stacks[++i]), INIT_MODE_SYS);
+	__set_SP_MODE((U32) (stacks[++i]), INIT_MODE_IRQ);
+	__set_SP_MODE((U32) (stacks[++i]), INIT_MODE_FIQ);
+	__set_SP_MODE((U32) (stacks[++i]), INIT_MODE_ABT);
+	__set_SP_MODE((U32) (stacks[++i]), INIT_MODE_UND);
 }
 
 /**************************************************************************//**
@@ -59,6 +63,24 @@ void SystemInit(void) {
 	GIC_EnableIRQ(HPS_TIMER1_IRQ_ID);
 	GIC_EnableIRQ(A9_TIMER_IRQ_ID);
 }
+
+/**************************************************************************//**
+ * @brief		Take a secondary core out of reset
+ * @param		cpu	the core, it enters Reset_Handler and waits there
+ *					for its boot stack
+ * @note		the boot ROM jumps to CPU1STARTADDR. A core that is
+ *				already out of reset is parked in Reset_Handler anyway.
+ *****************************************************************************/
+void SystemReleaseCPU(uint32_t cpu) {
+	extern void Reset_Handler(void);
+
+	if (cpu != 1) {
+		return;
+	}
+	SYSMGR_CPU1STARTADDR = (U32) Reset_Handler;
+	__dsb(0xF);
+	RSTMGR_MPUMODRST &= ~(1U << cpu);
+}
 /*
  *===========================================================================
  *                             END OF FILE
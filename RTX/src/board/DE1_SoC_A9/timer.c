@@ -157,3 +157,22 @@ void a9_timer_set_prescaler(uint8_t prescaler)
 	controlreg &= 0xF;
 	ARMTIMER->controlreg = (uint32_t) ((prescaler << 8) + controlreg);
 }
+void config_global_timer(U8 prescaler)
+{
+	// The counter can only be written while the timer is disabled, no comparator or interrupt
+	GLOBALTIMER->controlreg = 0;
+	GLOBALTIMER->counterlo = 0;
+	GLOBALTIMER->counterhi = 0;
+	GLOBALTIMER->controlreg = ((uint32_t)prescaler << 8) | 0x1;
+}
+U64 global_timer_get_val(void)
+{
+	// Read the upper word again until it did not change under the lower one
+	uint32_t hi;
+	uint32_t lo;
+	do {
+		hi = GLOBALTIMER->counterhi;
+		lo = GLOBALTIMER->counterlo;
+	} while (hi != GLOBALTIMER->counterhi);
+	return ((U64)hi << 32) | lo;
+}
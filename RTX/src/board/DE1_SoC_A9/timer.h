@@ -45,6 +45,12 @@
 #define SP0_TIMER_BASE  0xFFC08000
 #define SP1_TIMER_BASE  0xFFC09000
 #define ARM0_TIMER_BASE 0xFFFEC600
+#define GLOBAL_TIMER_BASE 0xFFFEC200  // shared by both cores
+
+#define HPS_TIMER_TICKS_PER_US  100     // both HPS timers count the 100 MHz osc1 clock
+#define HPS_TIMER0_TICK_COUNT   10000   // 100 us kernel tick from the 100 MHz osc1 clock
+#define A9_TIMER_PRESCALER_US   199     // 200 MHz PERIPHCLK / (199 + 1), the A9 timer counts us
+#define GLOBAL_TIMER_TICKS_PER_US 200  // 200 MHz PERIPHCLK, the global timer runs unscaled
 
 typedef unsigned        char uint8_t;
 typedef unsigned short  int uint16_t;
@@ -66,6 +72,16 @@ typedef struct{
 	uint32_t intstat;
 } arm_timer_t;
 
+typedef struct{
+	uint32_t counterlo;
+	uint32_t counterhi;
+	uint32_t controlreg;
+	uint32_t intstat;
+	uint32_t comparatorlo;
+	uint32_t comparatorhi;
+	uint32_t autoincrement;
+} global_timer_t;
+
 void timer_disable(int n);                                  // disable timer, n = 0-1 for HPS, n = 2 for A9 private
 void timer_enable(int n);                                   // enable timer, n = 0-1 for HPS, n = 2 for A9 private
 void timer_set_mode(int n, int mode);                       // set mode, 1 for user-defined count or auto and 0 for free-running or one-time
@@ -80,6 +96,8 @@ void a9_timer_set_prescaler(U8 prescaler);
 
 void config_hps_timer(int n, int count, int mode, int irq_mask);
 void config_a9_timer(int count, int mode, int irq_bit, U8 prescaler);
+void config_global_timer(U8 prescaler);                     // restart the 64 bit global timer from 0
+U64 global_timer_get_val(void);                             // 64 bit count of the global timer
 
 void TIMER0_Interrupt(void);
 void TIMER1_Interrupt(void);
@@ -88,5 +106,6 @@ void TIMER1_Interrupt(void);
 #define TIMER0 ((timer_t *)SP0_TIMER_BASE)
 #define TIMER1 ((timer_t *)SP1_TIMER_BASE)
 #define ARMTIMER ((arm_timer_t *) ARM0_TIMER_BASE)
+#define GLOBALTIMER ((global_timer_t *) GLOBAL_TIMER_BASE)
 
 #endif
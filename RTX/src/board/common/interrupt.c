@@ -206,6 +206,34 @@ void GIC_SetInterfacePriorityMask(uint32_t priority)
 	GICInterface->PMR = priority & 0xFFUL;
 }
 
+// Read the interrupt priority mask from CPU's PMR register.
+uint32_t GIC_GetInterfacePriorityMask(void)
+{
+	return (GICInterface->PMR);
+}
+
+// Mask interrupts with a priority value of priority or more on this CPU.
+// Returns the previous mask, restore it with GIC_SetInterfacePriorityMask.
+uint32_t GIC_RaisePriorityMask(uint32_t priority)
+{
+	uint32_t old = GICInterface->PMR;
+	if (priority < old)
+	{
+		GICInterface->PMR = priority & 0xFFUL;
+		__dsb(0xF);
+		__isb(0xF);
+	}
+	return old;
+}
+
+// Raise SGI IRQn on every CPU in cpu_mask, bit n for CPU n, through the GIC's SGIR register.
+// The dsb makes the sender's memory writes visible before the interrupt arrives.
+void GIC_SendSGI(uint32_t IRQn, uint32_t cpu_mask)
+{
+	__dsb(0xF);
+	GICDistributor->SGIR = ((cpu_mask & 0xFFUL) << 16U) | (IRQn & 0xFUL);
+}
+
 // Configures the group priority and subpriority split point using CPU's BPR register.
 void GIC_SetBinaryPoint(uint32_t binary_point)
 {
@@ -29,7 +29,7 @@
  * OF SUCH DAMAGE.
  */
 
-#include "../DE1_SoC_A9/printf.h"
+#include "printf.h"
 
 typedef void (*putcf) (void*,char);
 static putcf stdout_putf;
@@ -21,8 +21,8 @@
 ; * @authors     Yiqing Huang, Zehan Gao, ARM
 ; * @date        2021 JAN
 ; * @note        MMU part is taken out, simpify IRQ handlers.
-; *              The device dependent content is the RAM_BASE,
-; *              set it according to the specific device
+; *              The device dependent content is the RAM_BASE, it comes
+; *              from board_a9.inc of the board folder on the include path
 ; *              Other parts are generic to any A9 processor devices
 ; *
 ; *****************************************************************************/
@@ -30,13 +30,13 @@
 ;/*********************************************************************************************
 ; * @brief modifed version of ARM startup_VE_A9_MP.s
 ; * @note  MMU part is taken out, simpify IRQ handlers.
-; *        The device dependent content is the RAM_BASE, set it according to the specific device
+; *        The device dependent content is the RAM_BASE, each board sets it in its board_a9.inc
 ; *        Other parts are generic to any A9 processor devices
 ; *        This file references scatter file defined symbols, so it should be used together
 ; *        with the provided scatter file
 ; *********************************************************************************************/
 
-RAM_BASE        EQU     0x00000000      ; Cyclone V
+                GET     board_a9.inc    ; RAM_BASE of the board
 SVC_Stack_Size  EQU     0x00000000      ; we do not allocate SVC stack here, take it from g_k_stacks[0]
 
 ;reset of exception mode stacks go to c routine to set up
@@ -108,21 +108,33 @@ Reset_Handler   PROC
                 IMPORT  StackInit
                 IMPORT  SystemInit
                 IMPORT  main
+                IMPORT  k_cpu_main
+                IMPORT  g_cpu_boot_sp               ; SVC stack of each core, set by k_smp_init
                 IMPORT  g_k_stacks					; the kernel stack array symbol
                 IMPORT  g_k_stack_size              ; the kernel stack size for each task
+
+                MRC     p15, 0, R4, c0, c0, 5       ; Read MPIDR, R4 keeps the core number
+                ANDS    R4, R4, #3
+                BEQ     cpu0Stack
+
+                ; Park any cores other than 0 until the kernel hands them a stack
+                LDR     R1, =g_cpu_boot_sp
+goToSleep
+                WFE
+                LDR     R0, [R1, R4, LSL #2]
+                CMP     R0, #0
+                BEQ     goToSleep
+                MOV     SP, R0
+                B       cpuInit
+
+cpu0Stack
                 LDR     R0, =g_k_stacks             ; R0 has the starting address of g_k_stacks[][] array
                 LDR     R1, =g_k_stack_size         ; R1 has the kernel stack size
                 LDR     R1, [R1]
                 ADD     R0, R0, R1                  ; Move to the high address of the first task's stack
                 MOV     SP, R0                      ; Use the first task
 
-                ; Put any cores other than 0 to sleep
-                MRC     p15, 0, R0, c0, c0, 5     ; Read MPIDR
-                ANDS    R0, R0, #3
-goToSleep
-                WFINE
-                BNE     goToSleep
-
+cpuInit
                 MRC     p15, 0, R0, c1, c0, 0       ; Read CP15 System Control register
                 BIC     R0, R0, #(0x1 << 12)        ; Clear I bit 12 to disable I Cache
                 BIC     R0, R0, #(0x1 <<  2)        ; Clear C bit  2 to disable D Cache
@@ -135,6 +147,7 @@ goToSleep
 ; Configure ACTLR
                 MRC     p15, 0, r0, c1, c0, 1       ; Read CP15 Auxiliary Control Register
                 ORR     r0, r0, #(1 <<  1)          ; Enable L2 prefetch hint (UNK/WI since r4p1)
+                ORR     r0, r0, #(1 <<  6)          ; SMP bit, take part in coherency with the other core
                 MCR     p15, 0, r0, c1, c0, 1       ; Write CP15 Auxiliary Control Register
 ; Set Vector Base Address Register (VBAR) to point to this application's vector table
                 LDR     R0, =__Vectors
@@ -142,11 +155,18 @@ goToSleep
 
                 LDR     R0, =StackInit              ; Initialize stack for each exception mode
                 BLX     R0
+                CMP     R4, #0
+                BNE     cpuSecondary
                 LDR     R0, =SystemInit
                 BLX     R0                          ; copy vector table, set up system clocks
                 LDR     R0, =main
                 BLX     main                        ; start the main function
                 B       .                           ; loop if main ever returns
+
+cpuSecondary
+                LDR     R0, =k_cpu_main
+                BLX     R0                          ; becomes the null task of this core
+                B       .
                 ENDP
 
 Undef_Handler   PROC
@@ -23,6 +23,8 @@
 #ifndef _SYSTEM_A9_H
 #define _SYSTEM_A9_H
 
+#include <stdint.h>
+
 /*
  *===========================================================================
  *                            FUNCTION PROTOTYPES
@@ -35,6 +37,7 @@ extern "C" {
 
 extern void StackInit (void);
 extern void SystemInit (void);
+extern void SystemReleaseCPU (uint32_t cpu);
 
 #endif /* _SYSTEM_A9_H */
 /*
@@ -0,0 +1,109 @@
+/**************************************************************************//**
+ * @file     uart_tx.c
+ * @brief    UART0 transmit ring, shared by the boards
+ * @version  V1.2021.03
+ * @date     20 March 2021
+ *
+ * @note     Callers queue characters in the ring and the UART0 TX interrupt
+ *           sends them in FIFO sized bursts. Writers and the interrupt may
+ *           run on any core, so the ring has a spinlock, taken with the
+ *           UART interrupt of this core masked. The board's Serial.c gives
+ *           the FIFO access: UART0_GetTxRoom, UART0_PutTxData and
+ *           UART0_SetTxIRQ.
+ *
+ ******************************************************************************/
+
+#include "Serial.h"
+#include "interrupt.h"
+
+static char UART0_TxBuf[UART0_TX_BUF_SIZE];
+static volatile uint32_t UART0_TxHead = 0;      // next free slot
+static volatile uint32_t UART0_TxTail = 0;      // next char to send
+static volatile uint32_t UART0_TxBusy = 0;      // ring lock, writers and the interrupt on any core take it
+
+/*----------------------------------------------------------------------------
+  Take the TX ring, with the UART interrupt of this core masked meanwhile
+ *----------------------------------------------------------------------------*/
+static uint32_t UART0_TxLock(void)
+{
+  // mask only the UART so the tick still gets through, and a holder cannot be interrupted by itself
+  uint32_t pmr = GIC_RaisePriorityMask(UART0_IRQ_PRIO);
+
+  do {
+    while (UART0_TxBusy != 0);                        // held on the other core
+  } while (__ldrex(&UART0_TxBusy) != 0 || __strex(1, &UART0_TxBusy) != 0);
+  __dmb(0xF);
+  return pmr;
+}
+
+/*----------------------------------------------------------------------------
+  Give the TX ring back and restore the priority mask UART0_TxLock found
+ *----------------------------------------------------------------------------*/
+static void UART0_TxUnlock(uint32_t pmr)
+{
+  __dmb(0xF);
+  UART0_TxBusy = 0;
+  GIC_SetInterfacePriorityMask(pmr);
+}
+
+/*----------------------------------------------------------------------------
+  Move as much of the TX ring into UART0 as its FIFO takes, ring held
+ *----------------------------------------------------------------------------*/
+static void UART0_TxFill(void)
+{
+  uint32_t tail = UART0_TxTail;
+  uint32_t room = UART0_GetTxRoom();
+
+  while (room != 0 && tail != UART0_TxHead) {
+    UART0_PutTxData(UART0_TxBuf[tail & (UART0_TX_BUF_SIZE - 1)]);
+    tail++;
+    if (--room == 0) {
+      room = UART0_GetTxRoom();
+    }
+  }
+  UART0_TxTail = tail;
+  if (tail == UART0_TxHead) {
+    UART0_SetTxIRQ(0);                                // ring drained, stop TX interrupts
+  }
+}
+
+/*----------------------------------------------------------------------------
+  Queue characters for UART0, only waits for the UART when the ring is full
+ *----------------------------------------------------------------------------*/
+int UART0_TxWrite(const char *s, int len)
+{
+  uint32_t pmr = UART0_TxLock();
+  int i;
+
+  for (i = 0; i < len; i++) {
+    while (UART0_TxHead - UART0_TxTail >= UART0_TX_BUF_SIZE) {
+      // ring full, let the interrupt and the other core in while the FIFO drains,
+      // so a write longer than the ring may interleave with other writes
+      UART0_TxUnlock(pmr);
+      while (UART0_GetTxRoom() == 0);
+      pmr = UART0_TxLock();
+      UART0_TxFill();
+    }
+    UART0_TxBuf[UART0_TxHead & (UART0_TX_BUF_SIZE - 1)] = s[i];
+    UART0_TxHead++;
+  }
+  if (len > 0) {
+    // the TX interrupt sends the ring in bursts, prime it for UARTs that only
+    // raise it when the FIFO drains past a trigger level
+    UART0_SetTxIRQ(1);
+    UART0_TxFill();
+  }
+  UART0_TxUnlock(pmr);
+  return len;
+}
+
+/*----------------------------------------------------------------------------
+  TX interrupt handler (UART0)
+ *----------------------------------------------------------------------------*/
+void UART0_TxIRQ(void)
+{
+  uint32_t pmr = UART0_TxLock();
+
+  UART0_TxFill();
+  UART0_TxUnlock(pmr);
+}
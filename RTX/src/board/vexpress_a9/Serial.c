@@ -0,0 +1,235 @@
+/**************************************************************************//**
+ * @file     Serial.c
+ * @brief    PL011 UART driver for the QEMU vexpress-a9, same API as DE1_SoC
+ * @version  V1.2021.01
+ * @date     18 March 2021
+ * @author   Yiqing Huang, Zehan Gao, ARM
+ *
+ * @note     
+ *
+ ******************************************************************************/
+/* Copyright (c) 2011 - 2015 ARM LIMITED
+
+   All rights reserved.
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+   - Neither the name of ARM nor the names of its contributors may be used
+   to endorse or promote products derived from this software without
+   specific prior written permission.
+ *
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ ---------------------------------------------------------------------------*/
+
+#include "../vexpress_a9/Serial.h"
+
+/*----------------------------------------------------------------------------
+  Write String to Serial Port
+ *----------------------------------------------------------------------------*/
+int SER_PutStr(int n, char *s)
+{
+  if (s == NULL)
+    return 1;
+  if (n == 1) {         /* queue the whole string in one go */
+    int len = 0;
+    while (s[len] != 0) {
+      len++;
+    }
+    UART0_TxWrite(s, len);
+    return 0;
+  }
+  while (*s !=0) {      /* loop through each char in the string */
+    SER_PutChar(n, *s++);/* print the char, then ptr increments  */
+  }
+  return 0;
+}
+
+/*----------------------------------------------------------------------------
+  Write character to Serial Port
+ *----------------------------------------------------------------------------*/
+void SER_PutChar(int n, char c)
+{
+  if(n == 0){
+    JTAG_UART_PutChar(c);
+  }
+  else if(n == 1){
+    UART0_PutChar(c);
+  }
+}
+
+/*----------------------------------------------------------------------------
+  Read character from Serial Port (blocking read)
+ *----------------------------------------------------------------------------*/
+char SER_GetChar(int n){
+  if(n == 0){
+    return JTAG_UART_GetChar();
+  }
+  else if(n == 1){
+    return UART0_GetChar();
+  }
+  return '\0';
+}
+
+/*----------------------------------------------------------------------------
+  Program the baud rate of a PL011, divisor = clk / (16 * baud) in 16.6 fixed point
+ *----------------------------------------------------------------------------*/
+static void PL011_SetBaudRate(UART_Type *uart, uint32_t baud_rate)
+{
+  uint32_t divisor = (UART0_CLK * 4 + baud_rate / 2) / baud_rate;
+
+  uart->UARTIBRD = divisor >> 6;
+  uart->UARTFBRD = divisor & 0x3F;
+  uart->UARTLCR_H = UART_LCR_H_WLEN_8 | UART_LCR_H_FEN;  // the divisor only latches on an LCR_H write
+}
+
+/*----------------------------------------------------------------------------
+  UART0 initialization
+ *----------------------------------------------------------------------------*/
+void UART0_Init(void)
+{
+	UART0->UARTCR = 0;                      // disable while reprogramming
+	UART0->UARTICR = 0x7FF;                 // drop stale interrupts
+	UART0_SetBaudRate( 115200 ); 	        // set baud rate to 115200, 8 bits, FIFO enabled
+	UART0->UARTIFLS = 0;                    // RX and TX interrupts at 1/8 full
+	UART0->UARTIMSC = UART_INT_RX | UART_INT_RT;  //enable rx interrupts
+	UART0->UARTCR = UART_CR_EN;
+}
+
+/*----------------------------------------------------------------------------
+  Set baud rate
+ *----------------------------------------------------------------------------*/
+void UART0_SetBaudRate(uint32_t baud_rate)
+{
+  PL011_SetBaudRate(UART0, baud_rate);
+}
+
+/*----------------------------------------------------------------------------
+  Write character to UART0 (second -serial)
+ *----------------------------------------------------------------------------*/
+void UART0_PutChar(char c)
+{
+  UART0_TxWrite(&c, 1);
+}
+
+/*----------------------------------------------------------------------------
+  Characters the UART0 TX FIFO takes right now, see board/common/uart_tx.c
+ *----------------------------------------------------------------------------*/
+uint32_t UART0_GetTxRoom(void)
+{
+  return (UART0->UARTFR & UART_FR_TXFF) ? 0 : 1;    // the PL011 only tells full or not
+}
+
+void UART0_PutTxData(char c)
+{
+  UART0->UARTDR = c;
+}
+
+void UART0_SetTxIRQ(int enable)
+{
+  if (enable) {
+    UART0->UARTIMSC |= UART_INT_TX;
+  } else {
+    UART0->UARTIMSC &= ~UART_INT_TX;
+  }
+}
+
+/*----------------------------------------------------------------------------
+  Read character from UART0 (second -serial) (blocking read)
+ *----------------------------------------------------------------------------*/
+char UART0_GetChar (void)
+{
+  while (UART0->UARTFR & UART_FR_RXFE);             // Wait for a character to arrive
+  return UART0->UARTDR;
+}
+
+/*----------------------------------------------------------------------------
+ * Call back function for printf (using JTAG UART)
+ *----------------------------------------------------------------------------*/
+/**
+ * @brief   call back function for printf
+ * @note    first parameter p is not used for now. Polling UART is used
+ */
+
+void putc(void *p, char c)
+{
+  if ( p != NULL ) {
+    SER_PutStr(0,"putc: first parameter needs to be NULL");
+  } else {
+    SER_PutChar(0,c);
+  }
+}
+
+/*----------------------------------------------------------------------------
+  JTAG UART initialization, polled so no interrupts
+ *----------------------------------------------------------------------------*/
+void JTAG_UART_Init(void)
+{
+  JTAG_UART->UARTCR = 0;
+  PL011_SetBaudRate(JTAG_UART, 115200);
+  JTAG_UART->UARTIMSC = 0;
+  JTAG_UART->UARTCR = UART_CR_EN;
+}
+
+/*----------------------------------------------------------------------------
+  Write character to JTAG
+ *----------------------------------------------------------------------------*/
+void JTAG_UART_PutChar(char c)
+{
+  while (JTAG_UART->UARTFR & UART_FR_TXFF);         // Wait for room in the TX FIFO
+  JTAG_UART->UARTDR = c;
+}
+
+/*----------------------------------------------------------------------------
+  Read character from JTAG UART (blocking read)
+ *----------------------------------------------------------------------------*/
+char JTAG_UART_GetChar(void)
+{
+  while (JTAG_UART->UARTFR & UART_FR_RXFE);         // Wait for a character to arrive
+  return JTAG_UART->UARTDR & 0xFF;
+}
+
+int UART0_GetRxIRQStatus(void)
+{
+	return (UART0->UARTMIS & (UART_INT_RX | UART_INT_RT)) != 0;
+}
+
+int UART0_GetRxDataStatus(void)
+{
+	return (UART0->UARTFR & UART_FR_RXFE) == 0;
+}
+
+char UART0_GetRxData(void)
+{
+	return UART0->UARTDR & 0xFF;   // emptying the FIFO also clears the RX interrupts
+}
+
+int UART0_GetIRQType(void)
+{
+	uint32_t mis = UART0->UARTMIS;
+
+	if (mis & UART_INT_RX) {
+		return UART0_IIR_RX_DATA;
+	}
+	if (mis & UART_INT_RT) {
+		return UART0_IIR_RX_TIMEOUT;
+	}
+	if (mis & UART_INT_TX) {
+		UART0->UARTICR = UART_INT_TX;   // like reading the 16550 IIR, reporting it clears it
+		return UART0_IIR_TX_EMPTY;
+	}
+	return UART0_IIR_NONE;
+}
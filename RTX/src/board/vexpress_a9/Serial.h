@@ -0,0 +1,130 @@
+ /**************************************************************************//**
+ * @file     Serial.h
+ * @brief    PL011 UART driver for the QEMU vexpress-a9, same API as DE1_SoC
+ * @version  V1.2021.01
+ * @date     18 March 2021
+ * @author   Yiqing Huang, Zehan Gao, ARM
+ *
+ * @note     The kernel's UART0 is PL011 UART1 and the polled JTAG UART
+ *           console is PL011 UART0. QEMU's first -serial is the console,
+ *           the second one is the kernel's UART0.
+ *
+ ******************************************************************************/
+/* Copyright (c) 2011 - 2013 ARM LIMITED
+
+   All rights reserved.
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+   - Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+   - Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+   - Neither the name of ARM nor the names of its contributors may be used
+     to endorse or promote products derived from this software without
+     specific prior written permission.
+   *
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+   ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+   LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+   CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+   SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+   INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+   CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+   POSSIBILITY OF SUCH DAMAGE.
+   ---------------------------------------------------------------------------*/
+
+#ifndef SERIAL_H_
+#define SERIAL_H_
+
+typedef unsigned char uint8_t;
+typedef unsigned short int uint16_t;
+typedef unsigned int uint32_t;
+typedef unsigned __int64 uint64_t;
+
+#define   __RO     volatile const
+#define   __WO     volatile
+#define   __RW     volatile
+
+/* PL011 UART - Register Layout Typedef */
+typedef struct {
+  __RW uint32_t UARTDR;             /* 0x000 Data Register */
+  __RW uint32_t UARTRSR;            /* 0x004 Receive Status / Error Clear Register */
+  uint32_t RESERVED_0[4];           /* 0x008-0x014 */
+  __RO uint32_t UARTFR;             /* 0x018 Flag Register */
+  uint32_t RESERVED_1;              /* 0x01C */
+  __RW uint32_t UARTILPR;           /* 0x020 IrDA Low-Power Counter Register */
+  __RW uint32_t UARTIBRD;           /* 0x024 Integer Baud Rate Register */
+  __RW uint32_t UARTFBRD;           /* 0x028 Fractional Baud Rate Register */
+  __RW uint32_t UARTLCR_H;          /* 0x02C Line Control Register */
+  __RW uint32_t UARTCR;             /* 0x030 Control Register */
+  __RW uint32_t UARTIFLS;           /* 0x034 Interrupt FIFO Level Select Register */
+  __RW uint32_t UARTIMSC;           /* 0x038 Interrupt Mask Set/Clear Register */
+  __RO uint32_t UARTRIS;            /* 0x03C Raw Interrupt Status Register */
+  __RO uint32_t UARTMIS;            /* 0x040 Masked Interrupt Status Register */
+  __WO uint32_t UARTICR;            /* 0x044 Interrupt Clear Register */
+} UART_Type;
+
+#define UART0_BASE                      (0x1000A000u)  /* PL011 UART1 on the vexpress motherboard */
+#define UART0                           ((UART_Type *)UART0_BASE)
+
+#define JTAG_UART_BASE                  (0x10009000u)  /* PL011 UART0, stands in for the JTAG UART */
+#define JTAG_UART                       ((UART_Type *)JTAG_UART_BASE)
+
+#define UART0_CLK                       24000000  // OSC2 = 24MHz
+
+#define UART0_TX_BUF_SIZE               1024      // TX ring size in bytes, power of 2
+
+/* PL011 flag, control and interrupt bits */
+#define UART_FR_RXFE                    BIT(4)    // RX FIFO empty
+#define UART_FR_TXFF                    BIT(5)    // TX FIFO full
+#define UART_LCR_H_FEN                  BIT(4)    // FIFOs enabled
+#define UART_LCR_H_WLEN_8               (0x3 << 5)
+#define UART_CR_EN                      (BIT(0) | BIT(8) | BIT(9))  // UART, TX and RX enabled
+#define UART_INT_RX                     BIT(4)
+#define UART_INT_TX                     BIT(5)
+#define UART_INT_RT                     BIT(6)    // RX timeout
+
+/* UART0 interrupt identification, the DE1_SoC IIR codes built from UARTMIS */
+#define UART0_IIR_NONE                  0x1
+#define UART0_IIR_TX_EMPTY              0x2
+#define UART0_IIR_RX_DATA               0x4
+#define UART0_IIR_RX_TIMEOUT            0xC
+
+/* ECE350 START */
+#define BIT(X)                          ( 1 << (X) )
+#define NULL                            0
+/* ECE350 END */
+
+extern char SER_GetChar (int n);
+extern void SER_PutChar(int n, char c);
+extern int  SER_PutStr(int n, char *s);
+
+void UART0_Init(void);
+void UART0_PutChar(char c);
+char UART0_GetChar (void);
+void UART0_SetBaudRate(uint32_t);
+
+void JTAG_UART_Init(void);
+void JTAG_UART_PutChar(char c);
+char JTAG_UART_GetChar(void);
+
+extern int UART0_GetRxIRQStatus(void);
+extern int UART0_GetRxDataStatus(void);
+extern char UART0_GetRxData(void);
+extern int UART0_GetIRQType(void);
+
+extern uint32_t UART0_GetTxRoom(void);
+extern void UART0_PutTxData(char c);
+extern void UART0_SetTxIRQ(int enable);
+
+/* TX ring, board/common/uart_tx.c */
+extern int UART0_TxWrite(const char *s, int len);
+extern void UART0_TxIRQ(void);
+
+extern void putc(void *p, char c);     /* call back function for printf, use JTAG UART */
+
+#endif /* SERIAL_H_ */
@@ -0,0 +1,42 @@
+/*
+ ****************************************************************************
+ *
+ *                  UNIVERSITY OF WATERLOO ECE 350 RTOS LAB
+ *
+ *              Copyright 2020-2021 Yiqing Huang and Zehan Gao
+ *
+ *          This software is subject to an open source license and
+ *          may be freely redistributed under the terms of MIT License.
+ ****************************************************************************
+ */
+
+/**************************************************************************//**
+ * @file        device_a9.h
+ * @brief       Cortex-A9 device header file, QEMU vexpress-a9
+ *
+ * @version     V1.2021.01
+ * @authors     Yiqing Huang, Zehan Gao
+ * @date        2021 JAN
+ *
+ *****************************************************************************/
+
+#ifndef DEVICE_A9_H_
+#define DEVICE_A9_H_
+
+/*
+ *===========================================================================
+ *                             MACROS
+ *===========================================================================
+ */
+#define NUM_PRIV_MODES  0x00000006      				// 6 privileged modes
+#define STACK_SZ        0x00000200      				// 512 B stack for each mode
+#define RAM_START       0x60100000						// vexpress DRAM starts at 0x60000000
+#define RAM_END         0x6FFFFFFF					   	// end of the 256 MB given with -m 256M
+#define NUM_CPUS        2								// Cortex-A9 MPCore cores, run with -smp 2
+
+#endif
+/*
+ *===========================================================================
+ *                             END OF FILE
+ *===========================================================================
+ */
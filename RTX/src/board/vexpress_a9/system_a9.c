@@ -0,0 +1,91 @@
+/*
+ ****************************************************************************
+ *
+ *                  UNIVERSITY OF WATERLOO ECE 350 RTOS LAB
+ *
+ *                     Copyright 2020-2021 Yiqing Huang
+ *
+ *          This software is subject to an open source license and
+ *          may be freely redistributed under the terms of MIT License.
+ ****************************************************************************
+ */
+
+/**************************************************************************//**
+ * @file        system_a9.c
+ * @brief       Generic Cortex-A9 CMSIS System Initialization Source
+ *
+ * @version     V1.2021.01
+ * @authors     Yiqing Huang
+ * @date        2021 JAN
+ *
+ * @attention
+ * @note
+ * @details
+ *
+ *****************************************************************************/
+
+#include "k_HAL_CA.h"
+#include "../vexpress_a9/device_a9.h"
+#include "../vexpress_a9/interrupt.h"
+#include "../vexpress_a9/Serial.h"
+#include "../vexpress_a9/timer.h"
+
+// statically allocated initial stacks except for SVC mode, one set per core
+U32 g_stacks[NUM_CPUS][NUM_PRIV_MODES - 1][STACK_SZ >> 2];
+
+#define SYS_FLAGSSET            (*(volatile U32 *)0x10000030)   // where the boot monitor starts secondary cores
+#define SYS_FLAGSCLR            (*(volatile U32 *)0x10000034)
+
+/**************************************************************************//**
+ * @brief		Set up stacks for each privileged mode except for SVC mode
+ * @see			startup_a9.s Reset_Handler
+ *****************************************************************************/
+void StackInit(void) {
+	U32 (*stacks)[STACK_SZ >> 2] = g_stacks[k_cpu_id()];
+	int i = 0;
+	__set_SP_MODE((U32) (stacks[++i]), INIT_MODE_SYS);
+	__set_SP_MODE((U32) (stacks[++i]), INIT_MODE_IRQ);
+	__set_SP_MODE((U32) (stacks[++i]), INIT_MODE_FIQ);
+	__set_SP_MODE((U32) (stacks[++i]), INIT_MODE_ABT);
+	__set_SP_MODE((U32) (stacks[++i]), INIT_MODE_UND);
+}
+
+/**************************************************************************//**
+ * @brief		Setup the system.
+ *         		Initialize the System and update the SystemCoreClock variable.
+ * @note		not needed for lab1 or lab2
+ *****************************************************************************/
+
+void SystemInit(void) {
+	JTAG_UART_Init();
+	GIC_Enable();
+	GIC_EnableIRQ(UART0_Rx_IRQ_ID);
+	GIC_EnableIRQ(HPS_TIMER0_IRQ_ID);
+	GIC_EnableIRQ(HPS_TIMER1_IRQ_ID);
+	GIC_EnableIRQ(A9_TIMER_IRQ_ID);
+}
+
+/**************************************************************************//**
+ * @brief		Point a secondary core at Reset_Handler
+ * @param		cpu	the core, it enters Reset_Handler and waits there
+ *					for its boot stack
+ * @note		the vexpress boot monitor holds secondary cores in WFE until
+ *				SYS_FLAGS is set, the caller's SEV wakes them. QEMU starts
+ *				every core of a bare-metal image at its entry point, so
+ *				there the core is already parked in Reset_Handler.
+ *****************************************************************************/
+void SystemReleaseCPU(uint32_t cpu) {
+	extern void Reset_Handler(void);
+
+	if (cpu == 0 || cpu >= NUM_CPUS) {
+		return;
+	}
+	SYS_FLAGSCLR = 0xFFFFFFFF;
+	SYS_FLAGSSET = (U32) Reset_Handler;
+	__dsb(0xF);
+}
+/*
+ *===========================================================================
+ *                             END OF FILE
+ *===========================================================================
+ */
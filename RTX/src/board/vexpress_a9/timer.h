@@ -0,0 +1,122 @@
+/*
+ ****************************************************************************
+ *
+ *                  UNIVERSITY OF WATERLOO ECE 350 RTOS LAB
+ *
+ *                     Copyright 2020-2021 Zehan Gao
+ *                          All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  - Redistributions of source code must retain the above copyright
+ *    notice and the following disclaimer.
+ *
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************
+ */
+
+/**************************************************************************//**
+ * @file        timer.c
+ * @brief       Timer driver header, SP804 and MPCore private timer of the
+ *              QEMU vexpress-a9
+ * @version     V1.2021.03
+ * @authors     Zehan Gao
+ * @date        2021 MAR
+ *
+ * @note	Only support UART0_irq in current version
+ *		Reference to Intel University Program code
+ *		Timers 0-1 are timer 1 of the two SP804 modules, under the
+ *		DE1_SoC HPS timer API
+ *
+ *****************************************************************************/
+#ifndef TIMER_H_
+#define TIMER_H_
+
+#include "common.h"
+
+#define SP0_TIMER_BASE  0x10011000      // SP804 timer 0/1
+#define SP1_TIMER_BASE  0x10012000      // SP804 timer 2/3
+#define ARM0_TIMER_BASE 0x1E000600      // PERIPHBASE + 0x600
+#define GLOBAL_TIMER_BASE 0x1E000200    // PERIPHBASE + 0x200, shared by both cores
+
+#define HPS_TIMER_TICKS_PER_US  1       // both SP804s count the 1 MHz TIMCLK
+#define HPS_TIMER0_TICK_COUNT   100     // 100 us kernel tick from the 1 MHz SP804 TIMCLK
+#define A9_TIMER_PRESCALER_US   99      // QEMU clocks the private timer at 100 MHz, / (99 + 1)
+#define GLOBAL_TIMER_TICKS_PER_US 100  // QEMU clocks the global timer at 100 MHz
+
+/* SP804 control register bits */
+#define SP804_CTRL_SIZE32       0x02
+#define SP804_CTRL_INTEN        0x20
+#define SP804_CTRL_PERIODIC     0x40
+#define SP804_CTRL_ENABLE       0x80
+
+typedef unsigned        char uint8_t;
+typedef unsigned short  int uint16_t;
+typedef unsigned        int uint32_t;
+typedef unsigned        __int64 uint64_t;
+
+typedef struct{
+    uint32_t timer1load;                                    // we only use timer1 inside of each timer module
+    uint32_t timer1value;
+    uint32_t timer1control;
+    uint32_t timer1intclr;
+    uint32_t timer1ris;
+    uint32_t timer1mis;
+    uint32_t timer1bgload;
+} timer_t;
+
+typedef struct{
+	uint32_t loadcount;
+	uint32_t currentval;
+	uint32_t controlreg;
+	uint32_t intstat;
+} arm_timer_t;
+
+typedef struct{
+	uint32_t counterlo;
+	uint32_t counterhi;
+	uint32_t controlreg;
+	uint32_t intstat;
+	uint32_t comparatorlo;
+	uint32_t comparatorhi;
+	uint32_t autoincrement;
+} global_timer_t;
+
+void timer_disable(int n);                                  // disable timer, n = 0-1 for SP804, n = 2 for A9 private
+void timer_enable(int n);                                   // enable timer, n = 0-1 for SP804, n = 2 for A9 private
+void timer_set_mode(int n, int mode);                       // set mode, 1 for user-defined count or auto and 0 for free-running or one-time
+void timer_set_count(int n, int count);                     // set load count, only effective in periodic mode for n = 0-1
+void timer_clear_irq(int n);                                // clear timer's interrupt request
+unsigned int timer_get_current_val(int n);                  // get the current value of the timer's counter
+
+void hps_timer_set_irq_mask(int n, int irq_mask);           // set irq mask, 1 for no interrupts and 0 for interrupts
+void a9_timer_set_irq_bit(int n, int irq_bit);              // set irq bit, 0 for no interrupts and 1 for interrupts
+void a9_timer_set_prescaler(U8 prescaler);
+
+
+void config_hps_timer(int n, int count, int mode, int irq_mask);
+void config_a9_timer(int count, int mode, int irq_bit, U8 prescaler);
+void config_global_timer(U8 prescaler);                     // restart the 64 bit global timer from 0
+U64 global_timer_get_val(void);                             // 64 bit count of the global timer
+
+void TIMER0_Interrupt(void);
+void TIMER1_Interrupt(void);
+
+
+#define TIMER0 ((timer_t *)SP0_TIMER_BASE)
+#define TIMER1 ((timer_t *)SP1_TIMER_BASE)
+#define ARMTIMER ((arm_timer_t *) ARM0_TIMER_BASE)
+#define GLOBALTIMER ((global_timer_t *) GLOBAL_TIMER_BASE)
+
+#endif
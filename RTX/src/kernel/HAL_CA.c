@@ -44,8 +44,7 @@
 #include "interrupt.h"
 #include "Serial.h"
 #include "k_task.h"
-#include "timer.h"
-#include "printf.h"
+#include "k_irq.h"
 
 #pragma push
 #pragma arm
@@ -69,36 +68,6 @@ F_Bit           EQU     0x40                ; when F bit is set, FIQ is disabled
 T_Bit           EQU     0x20                ; when T bit is set, core is in Thumb state
 
 }
-
-/**************************************************************************//**
- * @brief   disable both IRQ and FIQ
- * @post    IRQ and FIQ disabled
- * TODO     needs more testing
- *****************************************************************************/
-__asm void __atomic_on(void)
-{
-        PRESERVE8
-        PUSH    {R4, LR}
-        MRS     R4, CPSR
-        ORR     R4, #I_Bit:OR:F_Bit ; set both I and F bits
-        MSR     CPSR_c, R4
-        POP     {R4, PC}
-}
-
-/**************************************************************************//**
- * @brief   enable both IRQ and FIQ
- * @post    IRQ and FIQ enabled
- * TODO     needs more testing
- *****************************************************************************/
-__asm void __atomic_off(void)
-{
-        PRESERVE8
-        PUSH    {R4, LR}
-        MRS     R4, CPSR
-        BIC     R4, #I_Bit:OR:F_Bit  ; clear both I and F bits
-        MSR     CPSR_c, R4
-        POP     {R4, PC}
-}
 #pragma pop
 
 /**************************************************************************//**
@@ -159,6 +128,7 @@ __asm void __set_SP_MODE (U32 sp, U32 mode) {
  * @brief   	SVC Handler (i.e. trap handler)
  * @pre     	The caller should be in USR/SYS mode
  *          	R12 contains trap table mapped kernel function entry point
+ *          	SVC #0 runs it under the kernel lock, SVC #1 without
  *          	Processor is in ARM Mode
  * @attention   Only handles ARM Mode
  *****************************************************************************/
@@ -170,6 +140,9 @@ __asm void SVC_Handler (void)
         PRESERVE8                       ; 8 bytes alignement of the stack
         ARM
         EXPORT  SVC_RESTORE
+        EXPORT  SVC_EXIT
+        IMPORT  k_svc_enter
+        IMPORT  k_svc_exit
 
 SVC_SAVE
 
@@ -178,18 +151,25 @@ SVC_SAVE
         STM     SP, {R0-R12, SP}^       ; push SP_USR and R0 - R12 onto the kernel stack
 
 
-        ;// extract SVC number, only handles #0
+        ;// extract SVC number, only handles #0 and #1
         MRS     R4,SPSR                 ; Get SPSR
         LDR     R4,[LR,#-4]             ; ARM:   Load Word
         BIC     R4,R4,#0xFF000000       ; Extract SVC Number
 
-        CMP     R4,#0
-        BNE     SVC_EXIT                ; if not SVC #0, go to SVC_EXIT
+        CMP     R4,#1
+        BHI     SVC_EXIT                ; if not SVC #0 or #1, go to SVC_EXIT
+
+        MOV     R0, R12                 ; the kernel function is the call site of the IRQs-off section
+        MOV     R1, R4
+        BL      k_svc_enter             ; take the kernel lock for SVC #0
+        LDM     SP, {R0-R3}             ; reload the arguments from the saved context
+        LDR     R12, [SP, #48]
 
         BLX     R12                     ; invoke the corresponding c kernel function
 
 SVC_RESTORE
         STR     R0, [SP]                ; save the function return value on R0 that is on top of the stack
+        BL      k_svc_exit              ; drop the kernel lock
 
 SVC_EXIT  
         LDM     SP, {R0-R12, SP}^       ; restore SP_USR and R0-R12 from their saved values on the stack
@@ -213,6 +193,8 @@ __asm void IRQ_Handler(void){
         SUB 	SP, SP, #8
         STM     SP, {LR, SP}^		; Push SP_USR onto the kernel stack
 
+        MRC     p15, 0, R0, c9, c13, 0  ; PMU cycle count at entry, passed to c_IRQ_Handler
+        MOV     R1, SP                  ; and the frame built above, see IRQ_FRAME_PC
         BL 	c_IRQ_Handler           ; Call the uart interrupt handler for UART0 interrupt
 
 EXIT_IRQ
@@ -225,57 +207,61 @@ EXIT_IRQ
 #pragma pop
 
 
-void c_IRQ_Handler(void)
+static U32 g_irq_nest[NUM_CPUS];		// IRQ handlers active on the kernel stack of each CPU
+static U32 g_irq_resched[NUM_CPUS];		// a handler asked for a reschedule, done at the outermost exit
+static U32 *g_irq_frame[NUM_CPUS];		// frame of the innermost IRQ each CPU is handling
+
+/**
+ * @brief   frame IRQ_Handler saved for the interrupt being handled on this
+ *          CPU, index it with IRQ_FRAME_PC and IRQ_FRAME_SPSR
+ * @pre     called from an IRQ handler
+ */
+const U32 *k_irq_frame(void)
 {
-	static unsigned int a9_timer_last = 0xFFFFFFFF; // the initial value of free-running timer
-	unsigned int a9_timer_curr;
+	return g_irq_frame[k_cpu_id()];
+}
 
-	char switch_flag = 0;
+/**************************************************************************//**
+ * @brief   C part of the IRQ handler, runs in SVC mode on the interrupted
+ *          task's kernel stack
+ * @note    IRQs are re-enabled while the handler runs, so the GIC lets a
+ *          higher priority interrupt preempt it. Only the outermost level
+ *          switches tasks, and only when no priority mask critical section
+ *          is held, otherwise the request waits for the next interrupt.
+ * @param   entry_cycles PMU cycle count sampled by IRQ_Handler on entry
+ * @param   frame   registers IRQ_Handler pushed on the kernel stack
+ *****************************************************************************/
+void c_IRQ_Handler(U32 entry_cycles, U32 *frame)
+{
 	// Read the ICCIAR from the CPU Interface in the GIC
 	U32 interrupt_ID = GIC_AckPending();
-	if (interrupt_ID == UART0_Rx_IRQ_ID)
-	{
-		if(UART0_GetRxIRQStatus())			// check if interrupt type is Data Receive
-		{
-			while(UART0_GetRxDataStatus())	// read while Data Ready is valid
-			{
-				char c = UART0_GetRxData();	// would also clear the interrupt if last character is read
-				SER_PutChar(1, c);	        // display back
-			}
-			switch_flag = 1;
-		}
-		else
-		{   // unexpected interrupt type
-			SER_PutStr(0, "Error interrupt type!\r\n");
-		}
-	}
-	else if(interrupt_ID == HPS_TIMER0_IRQ_ID)
-	{
-		timer_clear_irq(0);
-		a9_timer_curr = timer_get_current_val(2);	//get the current value of the free running timer
-		if ((a9_timer_last - a9_timer_curr) > 500000U)
-		{
-			printf("%d ms passed!\r\n", ((a9_timer_last - a9_timer_curr)/1000U));
-			a9_timer_last = a9_timer_curr;
-		}
-	}
-	else if(interrupt_ID == HPS_TIMER1_IRQ_ID)
-	{
-		timer_clear_irq(1);
-	}
-	else if(interrupt_ID == A9_TIMER_IRQ_ID)
+
+	if ((interrupt_ID & GIC_IAR_ID_MASK) == GIC_SPURIOUS_ID)
 	{
-		timer_clear_irq(2);
+		return;						// nothing pending, and there is nothing to end
 	}
-	else
+
+	U32 cpu = k_cpu_id();				// the task only moves to another CPU in k_tsk_run_new below
+	U32 *outer = g_irq_frame[cpu];
+
+	g_irq_nest[cpu]++;
+	g_irq_frame[cpu] = frame;
+	__enable_irq();
+	if (k_irq_dispatch(interrupt_ID))
 	{
-		printf("unrecognized interrupt!\r\n");
+		g_irq_resched[cpu] = 1;
 	}
+	__disable_irq();
+	g_irq_frame[cpu] = outer;
 	// Write to the End of Interrupt Register (ICCEOIR)
 	GIC_EndInterrupt(interrupt_ID);
-	// Make sure to call line 246 before context switching
-	if (switch_flag == 1)
+	g_irq_nest[cpu]--;
+	k_irq_account(interrupt_ID, entry_cycles);
+
+	// End the interrupt before context switching
+	if (g_irq_nest[cpu] == 0 && g_irq_resched[cpu] && GIC_PRIO_MASK_IS_NONE(GIC_GetInterfacePriorityMask()))
 	{
+		g_irq_resched[cpu] = 0;
 		k_tsk_run_new();
 	}
 }
@@ -104,8 +104,6 @@ typedef uint32_t        U32;
 /* START: ECE350 Functions */
 extern void __set_SP_MODE (U32 sp, U32 mode);
 extern void __ch_MODE (U32 mode);
-extern void __atomic_on(void);
-extern void __atomic_off(void);
 
 static __inline uint32_t __get_CPSR(void) {
     register uint32_t __regCPSR __asm("cpsr");
@@ -117,6 +115,93 @@ static __inline char __get_mode(void)
     return (char)(__get_CPSR() & 0x1FU);
 }
 
+static __inline uint32_t __get_MPIDR(void) {
+    register uint32_t __regMPIDR __asm("cp15:0:c0:c0:5");
+    return (__regMPIDR);
+}
+
+/* index of the core we are running on */
+static __inline uint32_t k_cpu_id(void)
+{
+    return __get_MPIDR() & 0x3U;
+}
+
+/* start the PMU cycle counter from zero, counts every CPU clock */
+static __inline void __enable_PMCCNTR(void) {
+    register uint32_t __regPMCR __asm("cp15:0:c9:c12:0");
+    register uint32_t __regPMCNTENSET __asm("cp15:0:c9:c12:1");
+    __regPMCR = __regPMCR | 0x5U;           // E: enable, C: reset cycle counter
+    __regPMCNTENSET = 0x80000000U;          // C: cycle counter enable
+}
+
+static __inline uint32_t __get_PMCCNTR(void) {
+    register uint32_t __regPMCCNTR __asm("cp15:0:c9:c13:0");
+    return (__regPMCCNTR);
+}
+
+static __inline uint32_t __get_PMCR(void) {
+    register uint32_t __regPMCR __asm("cp15:0:c9:c12:0");
+    return (__regPMCR);
+}
+
+/* PMU event counter n is reached through PMXEVTYPER and PMXEVCNTR
+   once it is selected */
+static __inline void __set_PMSELR(uint32_t n) {
+    register uint32_t __regPMSELR __asm("cp15:0:c9:c12:5");
+    __regPMSELR = n;
+    __isb(0xF);
+}
+
+static __inline void __set_PMXEVTYPER(uint32_t event) {
+    register uint32_t __regPMXEVTYPER __asm("cp15:0:c9:c13:1");
+    __regPMXEVTYPER = event;
+}
+
+static __inline uint32_t __get_PMXEVCNTR(void) {
+    register uint32_t __regPMXEVCNTR __asm("cp15:0:c9:c13:2");
+    return (__regPMXEVCNTR);
+}
+
+static __inline void __set_PMXEVCNTR(uint32_t count) {
+    register uint32_t __regPMXEVCNTR __asm("cp15:0:c9:c13:2");
+    __regPMXEVCNTR = count;
+}
+
+/* bit n is event counter n, bit 31 the cycle counter */
+static __inline void __set_PMCNTENSET(uint32_t mask) {
+    register uint32_t __regPMCNTENSET __asm("cp15:0:c9:c12:1");
+    __regPMCNTENSET = mask;
+}
+
+static __inline void __set_PMCNTENCLR(uint32_t mask) {
+    register uint32_t __regPMCNTENCLR __asm("cp15:0:c9:c12:2");
+    __regPMCNTENCLR = mask;
+}
+
+static __inline uint32_t __get_PMOVSR(void) {
+    register uint32_t __regPMOVSR __asm("cp15:0:c9:c12:3");
+    return (__regPMOVSR);
+}
+
+/* write ones to clear overflow flags */
+static __inline void __set_PMOVSR(uint32_t mask) {
+    register uint32_t __regPMOVSR __asm("cp15:0:c9:c12:3");
+    __regPMOVSR = mask;
+}
+
+/* drop the instruction cache, branch predictor and TLB entries of this core,
+   the D-cache is off so there is nothing to clean */
+static __inline void __inv_icache_tlb(void) {
+    register uint32_t __regICIALLU __asm("cp15:0:c7:c5:0");
+    register uint32_t __regBPIALL __asm("cp15:0:c7:c5:6");
+    register uint32_t __regTLBIALL __asm("cp15:0:c8:c7:0");
+    __regICIALLU = 0;
+    __regBPIALL = 0;
+    __regTLBIALL = 0;
+    __dsb(0xF);
+    __isb(0xF);
+}
+
 /* END: ECE350 Functions */
 
 #endif // ! K_HAL_CA_H_
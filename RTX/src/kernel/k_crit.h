@@ -0,0 +1,172 @@
+/**
+ * @file:   k_crit.h
+ * @brief:  kernel critical sections
+ * @date:   2021/03/14
+ *
+ * @note    k_crit_enter saves the CPSR and masks IRQ and FIQ, k_crit_exit
+ *          unmasks only what was unmasked when the matching enter ran, so
+ *          sections nest and are safe in SVC and IRQ mode alike. The
+ *          outermost section feeds the IRQs-off statistics.
+ *          Masking only keeps out this CPU, so every section also holds the
+ *          kernel lock, a spinlock that the CPU holding it can take again.
+ *          The heap and the kernel objects live under it. The ready queues
+ *          have spinlocks of their own, see k_rq.h. A task gives the kernel
+ *          lock up when it switches out and takes it back, at the same depth,
+ *          when it runs again, see k_tsk_run_new.
+ *          k_irq_save/k_irq_restore only mask, for code that takes no kernel
+ *          object, like yielding.
+ *          k_crit_enter_prio only raises the GIC priority mask, interrupts
+ *          of a higher priority than prio keep running. It is local to the
+ *          CPU and takes no lock.
+ */
+
+#ifndef K_CRIT_H_
+#define K_CRIT_H_
+
+#include "k_inc.h"
+#include "k_HAL_CA.h"
+#include "k_irq.h"
+#include "interrupt.h"
+
+#define KLOCK_NO_OWNER      0xFFFFFFFF
+
+typedef U32 K_CRIT;                     /* CPSR saved by k_crit_enter */
+typedef volatile U32 K_SPINLOCK;        /* 0 when free */
+
+typedef struct k_klock {
+    K_SPINLOCK      lock;
+    volatile U32    owner;              /* CPU holding the lock, KLOCK_NO_OWNER if none */
+    U32             depth;              /* nesting on the owner */
+} K_KLOCK;
+
+extern K_KLOCK g_klock;
+
+/* spin with WFE until the lock is free, the holder wakes us with SEV */
+static __inline void k_spin_lock(K_SPINLOCK *p_lock)
+{
+    while (1) {
+        if (__ldrex(p_lock) != 0) {
+            __clrex();
+            __wfe();
+        } else if (__strex(1, p_lock) == 0) {
+            break;
+        }
+    }
+    __dmb(0xF);                         // nothing inside moves before the lock is held
+}
+
+/* TRUE if the lock was free and is now held */
+static __inline int k_spin_trylock(K_SPINLOCK *p_lock)
+{
+    if (__ldrex(p_lock) != 0) {
+        __clrex();
+        return FALSE;
+    }
+    if (__strex(1, p_lock) != 0) {
+        return FALSE;
+    }
+    __dmb(0xF);
+    return TRUE;
+}
+
+static __inline void k_spin_unlock(K_SPINLOCK *p_lock)
+{
+    __dmb(0xF);                         // everything inside is visible before the lock is free
+    *p_lock = 0;
+    __dsb(0xF);
+    __sev();
+}
+
+/* IRQs must be masked */
+static __inline void k_klock_acquire(void)
+{
+    U32 cpu = k_cpu_id();
+
+    if (g_klock.owner != cpu) {         // only this CPU can have stored its own id
+        k_spin_lock(&g_klock.lock);
+        g_klock.owner = cpu;
+    }
+    g_klock.depth++;
+}
+
+static __inline void k_klock_release(void)
+{
+    if (--g_klock.depth == 0) {
+        g_klock.owner = KLOCK_NO_OWNER;
+        k_spin_unlock(&g_klock.lock);
+    }
+}
+
+/* give the kernel lock up for a context switch, returns the depth to retake */
+static __inline U32 k_klock_drop(void)
+{
+    U32 depth = 0;
+
+    if (g_klock.owner == k_cpu_id()) {
+        depth = g_klock.depth;
+        g_klock.depth = 0;
+        g_klock.owner = KLOCK_NO_OWNER;
+        k_spin_unlock(&g_klock.lock);
+    }
+    return depth;
+}
+
+/* take the kernel lock back at the depth k_klock_drop returned */
+static __inline void k_klock_retake(U32 depth)
+{
+    if (depth != 0) {
+        k_spin_lock(&g_klock.lock);
+        g_klock.owner = k_cpu_id();
+        g_klock.depth = depth;
+    }
+}
+
+static __inline K_CRIT k_irq_save(void)
+{
+    K_CRIT cpsr = __get_CPSR();
+
+    __disable_irq();
+    __disable_fiq();
+    if (!(cpsr & CPSR_I_BIT)) {
+        k_irqoff_enter((U32)__return_address());
+    }
+    return cpsr;
+}
+
+static __inline void k_irq_restore(K_CRIT cpsr)
+{
+    if (!(cpsr & CPSR_I_BIT)) {
+        k_irqoff_exit();
+        __enable_irq();
+    }
+    if (!(cpsr & CPSR_F_BIT)) {
+        __enable_fiq();
+    }
+}
+
+static __inline K_CRIT k_crit_enter(void)
+{
+    K_CRIT cpsr = k_irq_save();
+
+    k_klock_acquire();
+    return cpsr;
+}
+
+static __inline void k_crit_exit(K_CRIT cpsr)
+{
+    k_klock_release();
+    k_irq_restore(cpsr);
+}
+
+/* mask the interrupts of priority prio and lower, returns the old mask */
+static __inline U32 k_crit_enter_prio(U32 prio)
+{
+    return GIC_RaisePriorityMask(prio);
+}
+
+static __inline void k_crit_exit_prio(U32 pmr)
+{
+    GIC_SetInterfacePriorityMask(pmr);
+}
+
+#endif /* ! K_CRIT_H_ */
@@ -43,6 +43,7 @@
 
 #include "device_a9.h"
 #include "common.h"
+#include "k_HAL_CA.h"
 
 /*
  *===========================================================================
@@ -58,6 +59,9 @@
  *===========================================================================
  */
 
+struct k_mutex;
+struct k_res;
+
 /**
  * @brief TCB data structure definition to support two kernel tasks.
  * @note  You will need to add more fields to this structure.
@@ -66,13 +70,37 @@ typedef struct tcb {
     struct tcb* 	next;   /**> next tcb, not used in this example         */
     U32*        	ksp;    /**> ksp of the task, TCB_KSP_OFFSET = 4        */
     U8          	tid;    /**> task id                                    */
-    U8          	prio;   /**> Execution priority                         */
+    U8          	prio;   /**> Execution priority, inherited priority included */
     U8          	state;  /**> task state                                 */
     U8          	priv;   /**> = 0 unprivileged, =1 privileged            */
     void			(*task_entry)(void);  /* TODO: might remove later */
     U16				u_stack_size;
     U32				u_stack_hi;
     U32				u_stack_lo;
+    struct tcb*		wait_next;		/**> next tcb in the wait queue the task is blocked on */
+    struct tcb**	wait_q;			/**> head of the wait queue the task is on, NULL if none */
+    struct tcb*		rpc_q;			/**> clients blocked in msg_call on this task   */
+    void*			rpc_buf;		/**> request (client) or receive buffer (server) */
+    size_t			rpc_len;		/**> length of rpc_buf in bytes                 */
+    void*			rpc_reply;		/**> client reply buffer                        */
+    size_t			rpc_reply_len;	/**> length of rpc_reply in bytes               */
+    int				rpc_status;		/**> bytes transferred, or RTX_ERR              */
+    task_t			rpc_peer;		/**> server called (client) or client received (server) */
+    U32				notify_val;		/**> notification word                          */
+    U32				notify_mask;	/**> bits waited for in BLK_NOTIFY              */
+    int				wait_timer;		/**> timeout of the current wait, RTX_ERR if none */
+    U8				base_prio;		/**> priority set by tsk_create/tsk_set_prio     */
+    struct k_mutex*	blk_mutex;		/**> mutex the task is blocked on in BLK_MUTEX   */
+    struct k_mutex*	held;			/**> mutexes the task holds                     */
+    struct k_res*	res_held;		/**> ceiling resources held, last taken first    */
+    U32				klock_depth;	/**> kernel lock nesting saved while switched out */
+    U8				cpu;			/**> CPU whose ready queue the task is on or last ran on */
+    U8				affinity;		/**> CPUs the task may run on, never 0           */
+    U64				run_time;		/**> global timer ticks spent RUNNING, current stint excluded */
+    U64				run_start;		/**> global timer count when it last got a CPU  */
+    U32				nvcsw;			/**> switched out blocked, suspended or exiting */
+    U32				nivcsw;			/**> switched out still runnable: preempted or yielded */
+    U8				pmu_on;			/**> TRUE once the task selected a PMU event    */
 } TCB;
 
 /*
@@ -95,7 +123,8 @@ extern unsigned int Image$$ZI_DATA$$ZI$$Limit; 	// Linker defined symbol
                                                 // See ARM Compiler User Guide 5.x
 
 // task related globals are defined in k_task.c
-extern TCB *gp_current_task;    // always point to the current RUNNING task
+extern TCB *g_cur_task[NUM_CPUS];  // the RUNNING task of each CPU
+#define gp_current_task (g_cur_task[k_cpu_id()])    // always point to the current RUNNING task of this CPU
 
 // TCBs are statically allocated inside the OS image
 extern TCB g_tcbs[MAX_TASKS];
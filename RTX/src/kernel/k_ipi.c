@@ -0,0 +1,247 @@
+/**
+ * @file:   k_ipi.c
+ * @brief:  kernel inter-processor interrupts
+ * @date:   2021/03/17
+ *
+ * @note    Every IPI is the one SGI IPI_SGI_ID. What the target has to do
+ *          is ORed into its pending word with LDREX/STREX, and the SGI is
+ *          only raised when the word was empty, so a storm of wakeups
+ *          aimed at one core costs a single interrupt. The handler takes
+ *          the whole word before it acts on it, so work added after that
+ *          raises a new SGI.
+ *          Remote calls and cache maintenance run with IRQs masked on the
+ *          target. A CPU waiting on another one with IRQs masked keeps
+ *          running its own calls, so two CPUs calling each other do not
+ *          deadlock. A waiting caller must not hold the kernel lock or a
+ *          ready queue lock, the target may be spinning on it with IRQs
+ *          masked.
+ */
+
+#include "k_ipi.h"
+#include "k_crit.h"
+#include "k_irq.h"
+#include "k_smp.h"
+#include "k_prof.h"
+#include "interrupt.h"
+#include "printf.h"
+
+static volatile U32  g_ipi_pending[NUM_CPUS];           // work asked of each CPU
+static IPI_CALL_SLOT g_ipi_calls[NUM_CPUS][NUM_CPUS];   // [target][source]
+static volatile U32  g_sync_seq = 0;                    // cache syncs asked for so far
+static volatile U32  g_sync_done[NUM_CPUS];             // last sync each CPU has done
+static U32           g_ipi_sent[NUM_CPUS];              // SGIs raised by each CPU
+static U32           g_ipi_merged[NUM_CPUS];            // requests that found an SGI on its way
+
+/**
+ * @brief   clear bits of the pending word of cpu
+ * @return  the bits that were set
+ */
+static U32 ipi_take(U32 cpu, U32 bits)
+{
+    U32 old;
+
+    do {
+        old = __ldrex(&g_ipi_pending[cpu]);
+    } while (__strex(old & ~bits, &g_ipi_pending[cpu]));
+    return old & bits;
+}
+
+/**
+ * @brief   run the calls and cache maintenance in work on this CPU
+ * @pre     IRQs are masked
+ */
+static void ipi_run(U32 work)
+{
+    U32 cpu = k_cpu_id();
+
+    if (work & IPI_CALL) {
+        for (U32 src = 0; src < NUM_CPUS; src++) {
+            IPI_CALL_SLOT *p_slot = &g_ipi_calls[cpu][src];
+            IPI_FN fn = p_slot->fn;
+
+            if (fn != NULL) {
+                __dmb(0xF);             // arg is read after fn
+                fn(p_slot->arg);
+                __dmb(0xF);             // the call is done before the caller sees it
+                p_slot->fn = NULL;
+            }
+        }
+    }
+    if (work & IPI_SYNC) {
+        U32 seq = g_sync_seq;           // every sync asked for up to here is covered
+
+        __dmb(0xF);
+        __inv_icache_tlb();
+        g_sync_done[cpu] = seq;
+    }
+}
+
+/**
+ * @brief   IPI_SGI_ID handler
+ * @return  TRUE to reschedule on the way out
+ */
+static int k_ipi_irq(U32 irq_id, void *arg)
+{
+    U32 work = ipi_take(k_cpu_id(), ~0U);
+    K_CRIT crit;
+
+    if (work & IPI_SAMPLE) {
+        k_prof_sample();
+    }
+    if (work & (IPI_CALL | IPI_SYNC)) {
+        crit = k_irq_save();
+        ipi_run(work);
+        k_irq_restore(crit);
+    }
+    return (work & IPI_RESCHED) != 0;
+}
+
+/**
+ * @brief   install the IPI handler and enable it on CPU 0
+ * @pre     k_irq_init is done, IRQs are masked
+ */
+void k_ipi_init(void)
+{
+    k_irq_register(IPI_SGI_ID, k_ipi_irq, NULL);
+    k_ipi_cpu_init();
+}
+
+/**
+ * @brief   enable IPIs on the calling CPU
+ * @note    SGI enables and priorities are banked, every core sets its own
+ */
+void k_ipi_cpu_init(void)
+{
+    GIC_SetPriority(IPI_SGI_ID, IPI_IRQ_PRIO);
+    GIC_EnableIRQ(IPI_SGI_ID);
+}
+
+/**
+ * @brief   ask cpu to do work, one SGI however many requests pile up
+ * @note    safe from any context, a CPU that is not online is skipped
+ */
+void k_ipi_send(U32 cpu, U32 work)
+{
+    U32 old;
+
+    if (cpu >= NUM_CPUS || !g_cpu_online[cpu]) {
+        return;
+    }
+    do {
+        old = __ldrex(&g_ipi_pending[cpu]);
+    } while (__strex(old | work, &g_ipi_pending[cpu]));
+
+    if (old == 0) {
+        GIC_SendSGI(IPI_SGI_ID, 1U << cpu);
+        g_ipi_sent[k_cpu_id()]++;
+    } else {
+        g_ipi_merged[k_cpu_id()]++;
+    }
+}
+
+/**
+ * @brief   run fn(arg) on cpu with IRQs masked there
+ * @param   wait    TRUE to return once fn has run
+ * @return  RTX_OK on success, RTX_ERR if fn is NULL or cpu is not online
+ * @note    runs fn right away when cpu is the caller's own. Without wait
+ *          the next call from this CPU to cpu waits for this one.
+ */
+int k_ipi_call(U32 cpu, IPI_FN fn, void *arg, int wait)
+{
+    IPI_CALL_SLOT *p_slot;
+    K_CRIT crit;
+
+    if (cpu >= NUM_CPUS || fn == NULL || !g_cpu_online[cpu]) {
+        return RTX_ERR;
+    }
+
+    crit = k_irq_save();
+    if (cpu == k_cpu_id()) {
+        fn(arg);
+        k_irq_restore(crit);
+        return RTX_OK;
+    }
+
+    p_slot = &g_ipi_calls[cpu][k_cpu_id()];
+    while (p_slot->fn != NULL) {
+        k_ipi_poll();                   // the last call from here has not run yet
+    }
+    p_slot->arg = arg;
+    __dmb(0xF);                         // arg is in place before fn marks the slot
+    p_slot->fn = fn;
+    k_ipi_send(cpu, IPI_CALL);
+
+    while (wait && p_slot->fn != NULL) {
+        k_ipi_poll();
+    }
+    k_irq_restore(crit);
+    return RTX_OK;
+}
+
+/**
+ * @brief   drop the I-cache, branch predictors and TLBs of every online
+ *          CPU, for code or mappings changed at run time
+ * @note    returns once all CPUs are done, concurrent callers share the
+ *          work a CPU does
+ */
+void k_ipi_sync_caches(void)
+{
+    K_CRIT crit = k_irq_save();
+    U32 self = k_cpu_id();
+    U32 seq;
+
+    __dsb(0xF);                         // the caller's changes are out before anyone syncs
+    do {
+        seq = __ldrex(&g_sync_seq) + 1;
+    } while (__strex(seq, &g_sync_seq));
+
+    __inv_icache_tlb();
+    for (U32 cpu = 0; cpu < NUM_CPUS; cpu++) {
+        if (cpu != self) {
+            k_ipi_send(cpu, IPI_SYNC);
+        }
+    }
+    for (U32 cpu = 0; cpu < NUM_CPUS; cpu++) {
+        while (cpu != self && g_cpu_online[cpu] && (int)(g_sync_done[cpu] - seq) < 0) {
+            k_ipi_poll();
+        }
+    }
+    k_irq_restore(crit);
+}
+
+/**
+ * @brief   cache_sync syscall, k_ipi_sync_caches for tasks
+ * @return  RTX_OK
+ * @note    trapped without the kernel lock, a CPU spinning on it with
+ *          IRQs masked could not answer the IPI
+ */
+int k_cache_sync(void)
+{
+    k_ipi_sync_caches();
+    return RTX_OK;
+}
+
+/**
+ * @brief   run the calls and cache syncs pending on this CPU now
+ * @pre     IRQs are masked
+ * @note    a reschedule request is left for the IPI handler
+ */
+void k_ipi_poll(void)
+{
+    U32 work = ipi_take(k_cpu_id(), IPI_CALL | IPI_SYNC);
+
+    if (work != 0) {
+        ipi_run(work);
+    }
+}
+
+/**
+ * @brief   print how many IPIs each CPU raised and how many were merged
+ */
+void k_ipi_dump_stats(void)
+{
+    for (U32 cpu = 0; cpu < NUM_CPUS; cpu++) {
+        printf("cpu %u raised %u IPIs, %u more requests merged into pending ones\r\n",
+               cpu, g_ipi_sent[cpu], g_ipi_merged[cpu]);
+    }
+}
@@ -0,0 +1,38 @@
+/**
+ * @file:   k_ipi.h
+ * @brief:  kernel inter-processor interrupts header file
+ * @date:   2021/03/17
+ */
+
+#ifndef K_IPI_H_
+#define K_IPI_H_
+
+#include "k_inc.h"
+#include "common_ext.h"
+
+/* work a CPU can be asked to do, bits of its pending word */
+#define IPI_RESCHED         0x1         /* a task it should run is on its ready queue */
+#define IPI_CALL            0x2         /* run the functions queued by k_ipi_call */
+#define IPI_SYNC            0x4         /* drop its I-cache and TLB, see k_ipi_sync_caches */
+#define IPI_SAMPLE          0x8         /* take a profiler sample of what it was running */
+
+typedef void (*IPI_FN)(void *arg);
+
+/**
+ * @brief a remote function call, one slot per source and target CPU
+ */
+typedef struct ipi_call {
+    volatile IPI_FN fn;                 /* NULL once the target has run it */
+    void           *arg;
+} IPI_CALL_SLOT;
+
+void k_ipi_init(void);
+void k_ipi_cpu_init(void);
+void k_ipi_send(U32 cpu, U32 work);
+int  k_ipi_call(U32 cpu, IPI_FN fn, void *arg, int wait);
+void k_ipi_sync_caches(void);
+int  k_cache_sync(void);
+void k_ipi_poll(void);
+void k_ipi_dump_stats(void);
+
+#endif /* ! K_IPI_H_ */
@@ -0,0 +1,322 @@
+/**
+ * @file:   k_irq.c
+ * @brief:  kernel interrupt dispatch
+ * @date:   2021/03/07
+ *
+ * @note    c_IRQ_Handler looks the acknowledged interrupt up in a table
+ *          indexed by GIC interrupt ID, so a driver only has to register its
+ *          handler. Each entry counts how often its handler ran and the
+ *          longest run in PMU cycles. IRQ_Handler samples the cycle counter
+ *          on entry, so the whole entry to exit time, nested interrupts
+ *          included, goes into a per-IRQ maximum and log2 histogram.
+ *          The SVC handler and k_crit_enter/k_crit_exit mark the sections
+ *          that run with IRQs masked, and the longest one is kept with the
+ *          kernel function or return address that opened it.
+ *          A handler that has more than a few dozen cycles of work queues
+ *          the rest with k_irq_defer. The IRQ worker task runs the queue at
+ *          its own priority, preemptible like any other task. Producers
+ *          reserve a slot with LDREX/STREX, so nested handlers can queue
+ *          without masking IRQs. The worker is the only consumer. It sleeps
+ *          until the slot at the tail is filled, and it and the dispatcher
+ *          that wakes it only share g_defer_lock, never the kernel lock, so
+ *          an IRQ does not wait for a syscall on the other CPU.
+ */
+
+#include "k_irq.h"
+#include "k_crit.h"
+#include "k_HAL_CA.h"
+#include "k_log.h"
+#include "k_task.h"
+#include "k_ipi.h"
+#include "k_trace.h"
+#include "interrupt.h"
+#include "printf.h"
+
+static IRQ_DESC g_irq_table[NUM_IRQS];
+static IRQOFF_STATS g_irqoff[NUM_CPUS];
+
+static IRQ_WORK     g_defer_q[IRQ_DEFER_Q_LEN];
+static volatile U32 g_defer_head = 0;       // next slot to reserve, producers only
+static volatile U32 g_defer_tail = 0;       // next item to run, the worker only
+static U32          g_defer_dropped = 0;    // items refused because the queue was full
+static K_SPINLOCK   g_defer_lock = 0;       // the worker's check and block against its wakeup
+
+/**
+ * @brief   clear the dispatch table and start the cycle counter
+ * @pre     IRQs are masked
+ */
+void k_irq_init(void)
+{
+    for (U32 i = 0; i < NUM_IRQS; i++) {
+        g_irq_table[i].handler    = NULL;
+        g_irq_table[i].arg        = NULL;
+        g_irq_table[i].count      = 0;
+        g_irq_table[i].max_cycles = 0;
+        g_irq_table[i].max_total  = 0;
+        for (U32 j = 0; j < IRQ_HIST_BINS; j++) {
+            g_irq_table[i].hist[j] = 0;
+        }
+    }
+    __enable_PMCCNTR();
+}
+
+/**
+ * @brief   install handler for irq_id and enable it in the GIC
+ * @param   handler NULL removes the current handler and disables the interrupt
+ * @return  RTX_OK on success, RTX_ERR if the id is out of range, already
+ *          taken, or the caller is not privileged
+ */
+int k_irq_register(U32 irq_id, IRQ_HANDLER handler, void *arg)
+{
+    IRQ_DESC *p_desc;
+
+    if (irq_id >= NUM_IRQS) {
+        return RTX_ERR;
+    }
+    if (gp_current_task != NULL && gp_current_task->priv == 0) {
+        return RTX_ERR;
+    }
+
+    p_desc = &g_irq_table[irq_id];
+    if (handler == NULL) {
+        GIC_DisableIRQ(irq_id);
+        p_desc->handler = NULL;
+        return RTX_OK;
+    }
+    if (p_desc->handler != NULL) {
+        return RTX_ERR;
+    }
+
+    p_desc->arg        = arg;
+    p_desc->count      = 0;
+    p_desc->max_cycles = 0;
+    __dmb(0xF);                         // entry is complete before the handler is visible
+    p_desc->handler    = handler;
+    GIC_EnableIRQ(irq_id);
+
+    return RTX_OK;
+}
+
+/**
+ * @brief   copy out the statistics of irq_id
+ */
+int k_irq_get_stats(U32 irq_id, RTX_IRQ_STATS *buffer)
+{
+    if (irq_id >= NUM_IRQS || buffer == NULL) {
+        return RTX_ERR;
+    }
+    buffer->count      = g_irq_table[irq_id].count;
+    buffer->max_cycles = g_irq_table[irq_id].max_cycles;
+    buffer->max_total  = g_irq_table[irq_id].max_total;
+    buffer->defer_dropped = g_defer_dropped;
+    return RTX_OK;
+}
+
+/**
+ * @brief   print every interrupt that has fired and the longest IRQs-off section
+ * @note    runs with IRQs masked while printing, so it does not record itself
+ */
+int k_irq_dump_stats(void)
+{
+    printf("irq      count    handler      total  log2 cycles:count\r\n");
+    for (U32 i = 0; i < NUM_IRQS; i++) {
+        IRQ_DESC *p_desc = &g_irq_table[i];
+
+        if (p_desc->count == 0) {
+            continue;
+        }
+        printf("%3u %10u %10u %10u ", i, p_desc->count, p_desc->max_cycles, p_desc->max_total);
+        for (U32 j = 0; j < IRQ_HIST_BINS; j++) {
+            if (p_desc->hist[j] != 0) {
+                printf(" %u:%u", j, p_desc->hist[j]);
+            }
+        }
+        printf("\r\n");
+    }
+    for (U32 cpu = 0; cpu < NUM_CPUS; cpu++) {
+        printf("cpu %u longest IRQs-off section %u cycles, opened by 0x%x\r\n",
+               cpu, g_irqoff[cpu].max_cycles, g_irqoff[cpu].max_site);
+    }
+    printf("deferred work dropped %u\r\n", g_defer_dropped);
+    k_ipi_dump_stats();
+    g_irqoff[k_cpu_id()].active = 0;
+    return RTX_OK;
+}
+
+/**
+ * @brief   record the IRQ_Handler entry to exit time of an interrupt
+ * @param   iar             the value read from ICCIAR
+ * @param   entry_cycles    cycle count sampled at IRQ_Handler entry
+ * @pre     IRQs are masked
+ */
+void k_irq_account(U32 iar, U32 entry_cycles)
+{
+    U32 irq_id = iar & GIC_IAR_ID_MASK;
+    U32 cycles = __get_PMCCNTR() - entry_cycles;
+    U32 bin;
+
+    // IRQs were enabled to take this interrupt, so a section still open was
+    // left by a switch into a kernel task that never passed k_irqoff_exit
+    g_irqoff[k_cpu_id()].active = 0;
+
+    if (irq_id >= NUM_IRQS) {
+        return;
+    }
+    bin = (cycles == 0) ? 0 : 31 - __clz(cycles);
+    if (bin >= IRQ_HIST_BINS) {
+        bin = IRQ_HIST_BINS - 1;
+    }
+    g_irq_table[irq_id].hist[bin]++;
+    if (cycles > g_irq_table[irq_id].max_total) {
+        g_irq_table[irq_id].max_total = cycles;
+    }
+}
+
+/**
+ * @brief   an IRQs-off section starts
+ * @param   site    the kernel function or return address that masked IRQs
+ * @pre     IRQs are masked
+ */
+void k_irqoff_enter(U32 site)
+{
+    IRQOFF_STATS *p_stats = &g_irqoff[k_cpu_id()];
+
+    p_stats->site   = site;
+    p_stats->start  = __get_PMCCNTR();
+    p_stats->active = 1;
+}
+
+/**
+ * @brief   the IRQs-off section opened by k_irqoff_enter ends
+ * @note    a section that switched tasks may end in another task, which is
+ *          still right, IRQs stayed masked across the switch
+ */
+void k_irqoff_exit(void)
+{
+    IRQOFF_STATS *p_stats = &g_irqoff[k_cpu_id()];
+    U32 cycles;
+
+    if (!p_stats->active) {
+        return;
+    }
+    cycles = __get_PMCCNTR() - p_stats->start;
+    p_stats->active = 0;
+    if (cycles > p_stats->max_cycles) {
+        p_stats->max_cycles = cycles;
+        p_stats->max_site   = p_stats->site;
+    }
+}
+
+/**
+ * @brief   run the handler registered for an acknowledged interrupt
+ * @param   iar the value read from ICCIAR
+ * @return  non-zero if the handler asked for a reschedule
+ */
+int k_irq_dispatch(U32 iar)
+{
+    U32 irq_id = iar & GIC_IAR_ID_MASK;
+    IRQ_DESC *p_desc;
+    U32 start;
+    U32 cycles;
+    int resched;
+
+    if (irq_id >= NUM_IRQS || g_irq_table[irq_id].handler == NULL) {
+        KLOG1(KLOG_IRQ_UNKNOWN, irq_id);
+        return FALSE;
+    }
+
+    p_desc  = &g_irq_table[irq_id];
+    start   = __get_PMCCNTR();
+    KTRACE0(KTRACE_IRQ_ENTER, irq_id);
+    resched = p_desc->handler(irq_id, p_desc->arg);
+    cycles  = __get_PMCCNTR() - start;
+    KTRACE1(KTRACE_IRQ_EXIT, irq_id, resched);
+
+    p_desc->count++;
+    if (cycles > p_desc->max_cycles) {
+        p_desc->max_cycles = cycles;
+    }
+
+    // wake the worker if the handler left it something to do
+    if (g_defer_head != g_defer_tail) {
+        TCB *p_worker = &g_tcbs[TID_IRQ_WORKER];
+        K_CRIT crit = k_irq_save();
+
+        k_spin_lock(&g_defer_lock);
+        if (p_worker->state == BLK_DEFER) {
+            k_tsk_unblock(p_worker);
+            if (check_prio() != RTX_OK) {
+                resched = TRUE;
+            }
+        }
+        k_spin_unlock(&g_defer_lock);
+        k_irq_restore(crit);
+    }
+    return resched;
+}
+
+/**
+ * @brief   queue fn(arg) to run later in the IRQ worker task
+ * @return  RTX_OK on success, RTX_ERR if fn is NULL or the queue is full
+ * @note    meant for IRQ handlers, the worker is woken when the handler returns
+ */
+int k_irq_defer(IRQ_DEFER_FN fn, void *arg)
+{
+    IRQ_WORK *p_work;
+    U32 head;
+
+    if (fn == NULL) {
+        return RTX_ERR;
+    }
+
+    do {
+        head = __ldrex(&g_defer_head);
+        if (head - g_defer_tail >= IRQ_DEFER_Q_LEN) {
+            __clrex();
+            g_defer_dropped++;
+            return RTX_ERR;
+        }
+    } while (__strex(head + 1, &g_defer_head));
+
+    p_work = &g_defer_q[head & (IRQ_DEFER_Q_LEN - 1)];
+    p_work->fn  = fn;
+    p_work->arg = arg;
+    __dmb(0xF);                             // item is complete before it is marked so
+    p_work->seq = head + 1;
+
+    return RTX_OK;
+}
+
+/**
+ * @brief   privileged kernel task that runs deferred interrupt work
+ * @note    created by k_tsk_init with TID_IRQ_WORKER at IRQ_WORKER_PRIO
+ */
+void task_irq_worker(void)
+{
+    while (1) {
+        U32 tail = g_defer_tail;
+        IRQ_WORK *p_work = &g_defer_q[tail & (IRQ_DEFER_Q_LEN - 1)];
+        IRQ_DEFER_FN fn;
+        void *arg;
+        K_CRIT crit;
+
+        // check and block under g_defer_lock so a wakeup cannot slip in
+        // between. An empty queue or a slot reserved but not filled yet
+        // both wait, the producer's dispatcher wakes us once it is filled.
+        crit = k_irq_save();
+        k_spin_lock(&g_defer_lock);
+        while (p_work->seq != tail + 1) {
+            k_tsk_block_on(BLK_DEFER, &g_defer_lock);
+            k_spin_lock(&g_defer_lock);
+        }
+        k_spin_unlock(&g_defer_lock);
+        k_irq_restore(crit);
+
+        fn  = p_work->fn;
+        arg = p_work->arg;
+        __dmb(0xF);                         // item is read before the slot is handed back
+        g_defer_tail = tail + 1;
+
+        fn(arg);
+    }
+}
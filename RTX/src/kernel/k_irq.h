@@ -0,0 +1,70 @@
+/**
+ * @file:   k_irq.h
+ * @brief:  kernel interrupt dispatch header file
+ * @date:   2021/03/07
+ */
+
+#ifndef K_IRQ_H_
+#define K_IRQ_H_
+
+#include "k_inc.h"
+#include "common_ext.h"
+
+#define NUM_IRQS            256         /* GIC interrupt IDs covered by the table */
+#define GIC_IAR_ID_MASK     0x3FF       /* interrupt ID field of ICCIAR */
+#define GIC_SPURIOUS_ID     1023        /* ICCIAR value when nothing is pending */
+
+#define IRQ_HIST_BINS       20          /* bin n counts IRQs of 2^n to 2^(n+1)-1 cycles, the last bin takes the rest */
+#define IRQ_DEFER_Q_LEN     32          /* deferred work items queued, power of 2 */
+#ifndef IRQ_WORKER_PRIO
+#define IRQ_WORKER_PRIO     PRIO_KERNEL /* priority of the IRQ worker task, tsk_set_prio changes it later */
+#endif
+
+/* words of the frame IRQ_Handler pushes: SP_usr and LR_usr, R0-R12, LR_svc, then the SRS pair */
+#define IRQ_FRAME_PC        16          /* where the interrupted code resumes */
+#define IRQ_FRAME_SPSR      17          /* its CPSR, the mode is in the low 5 bits */
+
+typedef void (*IRQ_DEFER_FN)(void *arg);
+
+/**
+ * @brief one entry of the dispatch table, indexed by GIC interrupt ID
+ */
+typedef struct irq_desc {
+    IRQ_HANDLER     handler;
+    void           *arg;
+    U32             count;              /* times the handler ran */
+    U32             max_cycles;         /* longest handler run in CPU cycles */
+    U32             max_total;          /* longest IRQ_Handler entry to exit, nesting included */
+    U32             hist[IRQ_HIST_BINS];/* log2 histogram of entry to exit cycles */
+} IRQ_DESC;
+
+/**
+ * @brief longest stretch with IRQs masked on one CPU
+ */
+typedef struct irqoff_stats {
+    U32             active;             /* a section is open */
+    U32             start;              /* cycle count when it was opened */
+    U32             site;               /* who opened it */
+    U32             max_cycles;         /* longest section so far */
+    U32             max_site;           /* who opened the longest section */
+} IRQOFF_STATS;
+
+/**
+ * @brief one deferred work item, seq is written last like a log record
+ */
+typedef struct irq_work {
+    volatile U32    seq;                /* queue index + 1 once the item is complete */
+    IRQ_DEFER_FN    fn;
+    void           *arg;
+} IRQ_WORK;
+
+void k_irq_init(void);
+int  k_irq_dispatch(U32 iar);
+void k_irq_account(U32 iar, U32 entry_cycles);
+void k_irqoff_enter(U32 site);
+void k_irqoff_exit(void);
+int  k_irq_defer(IRQ_DEFER_FN fn, void *arg);
+void task_irq_worker(void);
+const U32 *k_irq_frame(void);
+
+#endif /* ! K_IRQ_H_ */
@@ -0,0 +1,93 @@
+/**
+ * @file:   k_log.c
+ * @brief:  kernel deferred binary log
+ * @date:   2021/03/06
+ *
+ * @note    Kernel and IRQ code log a format id and raw arguments into a
+ *          per-CPU ring instead of formatting through the busy-wait JTAG UART.
+ *          Writers reserve a slot with LDREX/STREX, so an IRQ may log while
+ *          it interrupts another writer on the same CPU. The null task drains
+ *          the rings and does the formatting when nothing else wants the CPU.
+ *          The oldest records are overwritten when a ring fills up.
+ *          Each message is printed after the time, CPU and task it was
+ *          logged at.
+ */
+
+#include "k_log.h"
+#include "k_HAL_CA.h"
+#include "k_time.h"
+#include "printf.h"
+
+static KLOG_RING g_klog[NUM_CPUS];
+
+#define KLOG_FMT(id, fmt)   fmt,
+static const char * const g_klog_fmts[KLOG_NUM_FORMATS] = {
+    KLOG_FORMATS(KLOG_FMT)
+};
+#undef KLOG_FMT
+
+/**
+ * @brief   record one log message on the calling CPU's ring
+ * @note    safe from IRQ handlers, does not mask interrupts
+ */
+void k_log(U32 fmt, U32 a0, U32 a1, U32 a2, U32 a3)
+{
+    KLOG_RING *p_ring = &g_klog[k_cpu_id()];
+    KLOG_REC *p_rec;
+    U32 idx;
+
+    do {
+        idx = __ldrex(&p_ring->head);
+    } while (__strex(idx + 1, &p_ring->head));
+
+    p_rec = &p_ring->rec[idx & (KLOG_BUF_SIZE - 1)];
+    p_rec->seq     = 0;                     // slot is being rewritten
+    __dmb(0xF);                             // a reader sees seq cleared before any field changes
+    p_rec->time    = (U32)k_get_time_us();
+    p_rec->fmt     = (U16)fmt;
+    p_rec->tid     = (gp_current_task == NULL) ? TID_NULL : gp_current_task->tid;
+    p_rec->args[0] = a0;
+    p_rec->args[1] = a1;
+    p_rec->args[2] = a2;
+    p_rec->args[3] = a3;
+    __dmb(0xF);                             // record is complete before it is marked so
+    p_rec->seq     = idx + 1;
+}
+
+/**
+ * @brief   format and print everything logged since the last drain
+ * @note    called by the null task, prints through the polled JTAG UART
+ */
+void k_log_drain(void)
+{
+    for (U32 cpu = 0; cpu < NUM_CPUS; cpu++) {
+        KLOG_RING *p_ring = &g_klog[cpu];
+        KLOG_REC rec;
+        U32 head = p_ring->head;
+
+        if (head - p_ring->tail > KLOG_BUF_SIZE) {
+            printf(g_klog_fmts[KLOG_LOST], head - p_ring->tail - KLOG_BUF_SIZE, cpu);
+            p_ring->tail = head - KLOG_BUF_SIZE;
+        }
+
+        while (p_ring->tail != head) {
+            KLOG_REC *p_rec = &p_ring->rec[p_ring->tail & (KLOG_BUF_SIZE - 1)];
+
+            if (p_rec->seq != p_ring->tail + 1) {
+                break;                      // still being written, pick it up next time
+            }
+            __dmb(0xF);                     // seq is read before the fields it covers
+            rec = *p_rec;
+            __dmb(0xF);
+            if (p_rec->seq != p_ring->tail + 1) {
+                break;                      // overwritten while we copied it
+            }
+            p_ring->tail++;
+
+            if (rec.fmt < KLOG_NUM_FORMATS) {
+                printf("klog: %u us cpu %u tid %u: ", rec.time, cpu, rec.tid);
+                printf(g_klog_fmts[rec.fmt], rec.args[0], rec.args[1], rec.args[2], rec.args[3]);
+            }
+        }
+    }
+}
@@ -0,0 +1,66 @@
+/**
+ * @file:   k_log.h
+ * @brief:  kernel deferred binary log header file
+ * @date:   2021/03/06
+ */
+
+#ifndef K_LOG_H_
+#define K_LOG_H_
+
+#include "k_inc.h"
+
+#define KLOG_BUF_SIZE       128     /* records per CPU, power of 2 */
+#define KLOG_MAX_ARGS       4
+
+/*
+ * Every message the kernel logs, in id order. Only the id and the raw
+ * arguments are recorded; the string is applied when the log is drained.
+ * Append new entries at the end so existing ids keep their meaning.
+ */
+#define KLOG_FORMATS(X) \
+    X(KLOG_LOST,                "klog: %u records lost on cpu %u\r\n") \
+    X(KLOG_IRQ_UNKNOWN,         "unrecognized interrupt %u!\r\n") \
+    X(KLOG_IRQ_UART_TYPE,       "Error interrupt type 0x%x!\r\n") \
+    X(KLOG_TIMER0_MS,           "%d ms passed!\r\n") \
+    X(KLOG_MEM_ALLOC,           "k_mem_alloc: requested memory size = %d\r\n") \
+    X(KLOG_MEM_ALLOC_OS,        "k_mem_alloc: Allocating memory for OS and not task!!!\r\n") \
+    X(KLOG_MEM_ALLOC_TID,       "k_mem_alloc: current task running %u\r\n") \
+    X(KLOG_MEM_DEALLOC,         "k_mem_dealloc: freeing 0x%x\r\n") \
+    X(KLOG_MEM_DEALLOC_OWNER,   "k_mem_dealloc: current task running %d trying to delete memory owned by %u\r\n") \
+    X(KLOG_MEM_DEALLOC_OS,      "k_mem_dealloc: freeing memory owned by null task/OS\r\n") \
+    X(KLOG_MEM_PADDING,         "calc_padding: padding of %d added\r\n")
+
+#define KLOG_ID(id, fmt)    id,
+enum klog_id {
+    KLOG_FORMATS(KLOG_ID)
+    KLOG_NUM_FORMATS
+};
+#undef KLOG_ID
+
+/**
+ * @brief one log record, seq is written last so the reader can tell a
+ *        complete record from one that is still being written
+ */
+typedef struct klog_rec {
+    volatile U32    seq;                    /* ring index + 1 once complete */
+    U32             time;                   /* low 32 bits of k_get_time_us */
+    U16             fmt;                    /* KLOG_* format id */
+    task_t          tid;                    /* task running when the record was logged */
+    U32             args[KLOG_MAX_ARGS];
+} KLOG_REC;
+
+typedef struct klog_ring {
+    volatile U32    head;                   /* next index to reserve, bumped with LDREX/STREX */
+    U32             tail;                   /* next index to drain */
+    KLOG_REC        rec[KLOG_BUF_SIZE];
+} KLOG_RING;
+
+void k_log(U32 fmt, U32 a0, U32 a1, U32 a2, U32 a3);
+void k_log_drain(void);
+
+#define KLOG0(fmt)              k_log((fmt), 0, 0, 0, 0)
+#define KLOG1(fmt, a)           k_log((fmt), (U32)(a), 0, 0, 0)
+#define KLOG2(fmt, a, b)        k_log((fmt), (U32)(a), (U32)(b), 0, 0)
+#define KLOG3(fmt, a, b, c)     k_log((fmt), (U32)(a), (U32)(b), (U32)(c), 0)
+
+#endif /* ! K_LOG_H_ */
@@ -41,12 +41,25 @@
 /**
  * @brief:  k_mem.c kernel API implementations, this is only a skeleton.
  * @author: Yiqing Huang
+ *
+ * @note    Blocks of up to 128 bytes are rounded up to a power of 2 size
+ *          class and cached per CPU once freed, so the common mem_alloc
+ *          and mem_dealloc only touch the magazine of their own CPU and
+ *          the block, without the kernel lock. A magazine that runs empty
+ *          refills MAG_BATCH blocks from the depot under the kernel lock,
+ *          or carves one block from the heap, and a full one flushes
+ *          MAG_BATCH blocks to the depot. Cached blocks count as allocated
+ *          in the heap until k_mem_count_extfrag or a failing allocation
+ *          hands them all back.
  */
 
 #include "k_mem.h"
 #include "k_task.h"
 #include "Serial.h"
 #include "common_ext.h"
+#include "k_log.h"
+#include "k_crit.h"
+#include "k_trace.h"
 #ifdef DEBUG_0
 #include "printf.h"
 #endif /* DEBUG_0 */
@@ -70,6 +83,11 @@ U32 g_p_stacks[MAX_TASKS][U_STACK_SIZE >> 2] __attribute__((aligned(8)));
 // Head of linked list of free memory segments
 static header *head = NULL;
 
+// freed small blocks, see k_mem.h
+static K_MAG g_mags[NUM_CPUS];
+static void *g_depot[MAG_CLASSES][MAG_DEPOT_MAX];	// under the kernel lock
+static U32   g_depot_n[MAG_CLASSES];
+
 // int (treated as bool) that keeps track of if we're allocating memory that is owned by the genearl OS
 // ex: when we call k_alloc_p_stack in k_mem.c
 int mem_owned_by_os = 0;
@@ -119,19 +137,190 @@ int k_mem_init(void)
     header *starting_header = create_header((header *)end_addr, (header *)(U32)RAM_END, RAM_END - (end_addr + sizeof(header)), FREE); /* Starting metadata block */
 
     head = starting_header; /* Header metadata block that ALWAYS points to first metadata chunk that is free */
+
+    // cached blocks belonged to the old heap
+    for (int cpu = 0; cpu < NUM_CPUS; cpu++) {
+        for (int c = 0; c < MAG_CLASSES; c++) {
+            g_mags[cpu].rounds[c] = 0;
+        }
+    }
+    for (int c = 0; c < MAG_CLASSES; c++) {
+        g_depot_n[c] = 0;
+    }
     return RTX_OK;
 }
 
+static void* mem_alloc(size_t size);
+static int mem_dealloc(void *ptr);
+
+/* the size class of a request, -1 if it is too large to cache */
+static int mag_class(size_t size)
+{
+	int c = 0;
+
+	if (size == 0) {
+		return -1;
+	}
+	while (c < MAG_CLASSES && (MAG_MIN_SIZE << c) < size) {
+		c++;
+	}
+	return (c < MAG_CLASSES) ? c : -1;
+}
+
+/* the header of the block mem_alloc returned ptr for */
+static header *mag_header(void *ptr)
+{
+	header *seg_start = (header *)((U32)ptr - sizeof(header));
+	return (header *)((U32)seg_start - calc_padding((U32)seg_start));
+}
+
+/* give a cached block back to the heap, the kernel lock is held */
+static void mag_release(void *ptr)
+{
+	header *p_hdr = mag_header(ptr);
+
+	p_hdr->is_allocated = ALLOCATED;
+	p_hdr->tid = 0;
+	p_hdr->check = 0;
+	mem_dealloc(ptr);
+}
+
+/**
+ * @brief   hand every cached block back to the heap so it can coalesce
+ * @pre     the kernel lock is held
+ */
+static void mag_drain(void)
+{
+	for (int cpu = 0; cpu < NUM_CPUS; cpu++) {
+		K_MAG *p_mag = &g_mags[cpu];
+
+		k_spin_lock(&p_mag->lock);
+		for (int c = 0; c < MAG_CLASSES; c++) {
+			while (p_mag->rounds[c] > 0) {
+				mag_release(p_mag->blocks[c][--p_mag->rounds[c]]);
+			}
+		}
+		k_spin_unlock(&p_mag->lock);
+	}
+	for (int c = 0; c < MAG_CLASSES; c++) {
+		while (g_depot_n[c] > 0) {
+			mag_release(g_depot[c][--g_depot_n[c]]);
+		}
+	}
+}
+
+/**
+ * @brief   allocate a block of class c from the magazine of this CPU
+ * @note    lock order is the kernel lock before a magazine lock, so a miss
+ *          lets go of the magazine to take the kernel lock
+ */
+static void *mag_alloc(int c)
+{
+	K_CRIT crit = k_irq_save();			// no migration, the magazine is this CPU's
+	K_MAG *p_mag = &g_mags[k_cpu_id()];
+	void *ptr = NULL;
+
+	k_spin_lock(&p_mag->lock);
+	if (p_mag->rounds[c] == 0) {
+		K_CRIT kcrit;
+
+		k_spin_unlock(&p_mag->lock);
+		kcrit = k_crit_enter();
+		k_spin_lock(&p_mag->lock);
+		while (p_mag->rounds[c] < MAG_BATCH && g_depot_n[c] > 0) {
+			p_mag->blocks[c][p_mag->rounds[c]++] = g_depot[c][--g_depot_n[c]];
+		}
+		if (p_mag->rounds[c] == 0) {
+			k_spin_unlock(&p_mag->lock);
+			ptr = mem_alloc(MAG_MIN_SIZE << c);
+			if (ptr == NULL) {
+				mag_drain();
+				ptr = mem_alloc(MAG_MIN_SIZE << c);
+			}
+			if (ptr != NULL) {
+				mag_header(ptr)->check = MAG_TAG | c;
+			}
+			k_crit_exit(kcrit);
+			k_irq_restore(crit);
+			return ptr;
+		}
+		k_crit_exit(kcrit);				// the magazine lock is still held
+	}
+	ptr = p_mag->blocks[c][--p_mag->rounds[c]];
+	k_spin_unlock(&p_mag->lock);
+
+	mag_header(ptr)->is_allocated = ALLOCATED;
+	mag_header(ptr)->tid = k_tsk_get_tid();
+	k_irq_restore(crit);
+	return ptr;
+}
+
+/**
+ * @brief   move a block from ALLOCATED to MAG_CACHED in one LDREXB/STREXB
+ * @return  TRUE if the caller did it, FALSE if the block was not ALLOCATED
+ * @note    of two CPUs freeing the same block, only one gets to cache it
+ */
+static int mag_claim(header *p_hdr)
+{
+	volatile U8 *p_state = &p_hdr->is_allocated;
+
+	do {
+		if (__ldrex(p_state) != ALLOCATED) {
+			__clrex();
+			return FALSE;
+		}
+	} while (__strex(MAG_CACHED, p_state) != 0);
+	__dmb(0xF);
+	return TRUE;
+}
+
+/**
+ * @brief   cache a freed block of class c in the magazine of this CPU
+ * @pre     mag_claim took the block
+ */
+static void mag_free(void *ptr, int c)
+{
+	K_CRIT crit = k_irq_save();
+	K_MAG *p_mag = &g_mags[k_cpu_id()];
+	header *p_hdr = mag_header(ptr);
+
+	p_hdr->tid = 0;
+
+	k_spin_lock(&p_mag->lock);
+	if (p_mag->rounds[c] == MAG_ROUNDS) {
+		K_CRIT kcrit;
+
+		k_spin_unlock(&p_mag->lock);
+		kcrit = k_crit_enter();
+		k_spin_lock(&p_mag->lock);
+		for (int i = 0; i < MAG_BATCH && p_mag->rounds[c] > 0; i++) {
+			void *p_old = p_mag->blocks[c][--p_mag->rounds[c]];
+
+			if (g_depot_n[c] < MAG_DEPOT_MAX) {
+				g_depot[c][g_depot_n[c]++] = p_old;
+			} else {
+				mag_release(p_old);
+			}
+		}
+		k_crit_exit(kcrit);
+	}
+	p_mag->blocks[c][p_mag->rounds[c]++] = ptr;
+	k_spin_unlock(&p_mag->lock);
+	k_irq_restore(crit);
+}
+
 void* k_mem_alloc_os(size_t size) {
+	K_CRIT crit = k_crit_enter();
 	mem_owned_by_os = 1;
-	void* temp = k_mem_alloc(size);
+	void* temp = mem_alloc(size);
 	mem_owned_by_os = 0;
+	k_crit_exit(crit);
 	return temp;
 }
 
-void* k_mem_alloc(size_t size) {
+static void* mem_alloc(size_t size) {
 	#ifdef DEBUG_0
-	printf("k_mem_alloc: requested memory size = %d\r\n", size);
+	KLOG1(KLOG_MEM_ALLOC, size);
 	#endif /* DEBUG_0 */
     
     /* Check to make sure that k_mem_init has been called */
@@ -157,7 +346,7 @@ void* k_mem_alloc(size_t size) {
 	if (mem_owned_by_os) {
 		temp_tid = 0;
 		#ifdef DEBUG_0
-		printf("k_mem_alloc: Allocating memory for OS and not task!!!\r\n", size);
+		KLOG0(KLOG_MEM_ALLOC_OS);
 		#endif /* DEBUG_0 */
 	}
 
@@ -200,8 +389,9 @@ void* k_mem_alloc(size_t size) {
 		seg_start->size = size + head_round + right_padding;
 		seg_start->is_allocated = ALLOCATED;
 		seg_start->tid = temp_tid;
+		seg_start->check = 0;
 		#ifdef DEBUG_0
-			printf("k_mem_alloc: current task running %u\r\n", temp_tid);
+			KLOG1(KLOG_MEM_ALLOC_TID, temp_tid);
 		#endif /* DEBUG_0 */
 		
 
@@ -230,8 +420,9 @@ void* k_mem_alloc(size_t size) {
 		seg_start->next = NULL;
 		seg_start->is_allocated = ALLOCATED;
 		seg_start->tid = temp_tid;
+		seg_start->check = 0;
 		#ifdef DEBUG_0
-			printf("k_mem_alloc: current task running %u\r\n", temp_tid);
+			KLOG1(KLOG_MEM_ALLOC_TID, temp_tid);
 		#endif /* DEBUG_0 */
 
 	}
@@ -243,9 +434,29 @@ void* k_mem_alloc(size_t size) {
 
 }
 
-int k_mem_dealloc(void *ptr) {
+void* k_mem_alloc(size_t size) {
+	int c = mag_class(size);
+	void* temp;
+	if (c >= 0 && head != NULL) {
+		temp = mag_alloc(c);
+		KTRACE2(KTRACE_MEM_ALLOC, 0, size, temp);
+		return temp;
+	}
+
+	K_CRIT crit = k_crit_enter();
+	temp = mem_alloc(size);
+	if (temp == NULL && size != 0 && head != NULL) {
+		mag_drain();					// the memory may be sitting in the caches
+		temp = mem_alloc(size);
+	}
+	k_crit_exit(crit);
+	KTRACE2(KTRACE_MEM_ALLOC, 0, size, temp);
+	return temp;
+}
+
+static int mem_dealloc(void *ptr) {
 #ifdef DEBUG_0
-    printf("k_mem_dealloc: freeing 0x%x\r\n", (U32)ptr);
+    KLOG1(KLOG_MEM_DEALLOC, ptr);
 #endif /* DEBUG_0 */
     header *seg_start = (header *)((U32)ptr - sizeof(header)); /* Go to start of header */
     seg_start = (header *)((U32)seg_start - calc_padding((U32)seg_start));
@@ -259,13 +470,13 @@ int k_mem_dealloc(void *ptr) {
 	{
 		/*current task isn't task freeing memory*/
 		#ifdef DEBUG_0
-			printf("k_mem_dealloc: current task running %d trying to delete memory owned by %u\r\n", temp_tid, seg_start->tid);
+			KLOG2(KLOG_MEM_DEALLOC_OWNER, temp_tid, seg_start->tid);
 		#endif /* DEBUG_0 */
 		return RTX_ERR;
 	}
 	#ifdef DEBUG_0
 	if (temp_tid == 0) {
-		printf("k_mem_dealloc: freeing memory owned by null task/OS\r\n");
+		KLOG0(KLOG_MEM_DEALLOC_OS);
 	}
 	#endif /* DEBUG_0 */
     if (seg_start->is_allocated == FREE)
@@ -291,12 +502,40 @@ int k_mem_dealloc(void *ptr) {
     return coalesce(head, head->next);
 }
 
+int k_mem_dealloc(void *ptr) {
+	if (ptr == NULL) {
+		return RTX_ERR;
+	}
+
+	header *p_hdr = mag_header(ptr);
+	if ((p_hdr->check & ~0xFFU) == MAG_TAG) {
+		task_t tid = k_tsk_get_tid();
+		// a cached block is not ALLOCATED, so a double free fails in mag_claim
+		if ((p_hdr->tid != tid && p_hdr->tid != 0) || !mag_claim(p_hdr)) {
+			return RTX_ERR;
+		}
+		mag_free(ptr, p_hdr->check & 0xFF);
+		KTRACE2(KTRACE_MEM_FREE, 0, ptr, RTX_OK);
+		return RTX_OK;
+	}
+
+	K_CRIT crit = k_crit_enter();
+	int ret = mem_dealloc(ptr);
+	k_crit_exit(crit);
+	KTRACE2(KTRACE_MEM_FREE, 0, ptr, ret);
+	return ret;
+}
+
 
 int k_mem_count_extfrag(size_t size)
 {
 #ifdef DEBUG_0
     printf("k_mem_extfrag: size = %d\r\n", size);
 #endif /* DEBUG_0 */
+    K_CRIT crit = k_crit_enter();
+    mag_drain();                        // cached blocks are free memory too
+    k_crit_exit(crit);
+
     header *temp = head;
     int counter = 0;
     while (temp != (header *)(U32)RAM_END)
@@ -403,7 +642,7 @@ int calc_padding(U32 address){
 		return 0;
 	}
 #ifdef DEBUG_0
-	printf("calc_padding: padding of %d added\r\n", (8 -address % 8));
+	KLOG1(KLOG_MEM_PADDING, 8 - address % 8);
 #endif
 
 	return (8 -address % 8);
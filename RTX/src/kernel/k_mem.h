@@ -43,6 +43,29 @@
 #define K_MEM_H_
 #include "k_inc.h"
 #include "common_ext.h"
+#include "k_crit.h"
+
+/*
+ * ------------------------------------------------------------------------
+ *                 per-CPU magazines of small blocks
+ * ------------------------------------------------------------------------
+ */
+#define MAG_CLASSES     4           /* 16, 32, 64 and 128 byte blocks */
+#define MAG_MIN_SIZE    16          /* block size of class 0, each class doubles it */
+#define MAG_ROUNDS      8           /* blocks each CPU keeps per class */
+#define MAG_BATCH       4           /* blocks moved between a magazine and the depot at once */
+#define MAG_DEPOT_MAX   32          /* blocks per class the depot keeps, the rest go back to the heap */
+#define MAG_TAG         0x4D414700  /* header check of a block that may be cached, ORed with its class */
+#define MAG_CACHED      2           /* header is_allocated while a magazine or the depot holds it */
+
+/**
+ * @brief cache of freed small blocks of one CPU, a cache line of its own
+ */
+typedef struct k_mag {
+    K_SPINLOCK      lock;           /* only contended while k_mem_count_extfrag drains */
+    U32             rounds[MAG_CLASSES];
+    void           *blocks[MAG_CLASSES][MAG_ROUNDS];
+} __attribute__((aligned(32))) K_MAG;
 
 /*
  * ------------------------------------------------------------------------
@@ -45,3 +45,166 @@ int k_mbx_ls(task_t *buf, int count) {
 #endif /* DEBUG_0 */
     return 0;
 }
+
+/*
+ *===========================================================================
+ *                    SYNCHRONOUS SEND/RECEIVE/REPLY
+ *===========================================================================
+ */
+
+/* Messages are copied straight from the client's buffer into the server's and
+ * back again, so nothing is queued in a mailbox and nothing is allocated.
+ * A call that finds the server already in msg_receive costs one switch to the
+ * server and one switch back on the reply. */
+
+static size_t msg_copy(void *dst, const void *src, size_t len)
+{
+    U8 *p_dst = (U8 *)dst;
+    const U8 *p_src = (const U8 *)src;
+
+    for (size_t i = 0; i < len; i++) {
+        p_dst[i] = p_src[i];
+    }
+    return len;
+}
+
+/* copy the client's request into the server's receive buffer */
+static void msg_deliver(TCB *p_server, TCB *p_client)
+{
+    size_t len = p_client->rpc_len;
+
+    if (len > p_server->rpc_len) {
+        len = p_server->rpc_len;
+    }
+    p_server->rpc_status = msg_copy(p_server->rpc_buf, p_client->rpc_buf, len);
+    p_server->rpc_peer = p_client->tid;
+}
+
+/**
+ * @brief   send a request to a task and block until it replies
+ * @return  number of reply bytes copied into reply->base, RTX_ERR on failure
+ */
+int k_msg_call(task_t tid, const RTX_IOV *req, RTX_IOV *reply) {
+#ifdef DEBUG_0
+    printf("k_msg_call: tid = %d, req=0x%x, reply=0x%x\r\n", tid, req, reply);
+#endif /* DEBUG_0 */
+    TCB *p_client = gp_current_task;
+    TCB *p_server;
+
+    if (req == NULL || reply == NULL || req->base == NULL || reply->base == NULL || tid >= MAX_TASKS || tid == p_client->tid) {
+        return RTX_ERR;
+    }
+
+    p_server = &g_tcbs[tid];
+    if (p_server->state == DORMANT || p_server->state == EXITING || tid == TID_NULL) {
+        return RTX_ERR;
+    }
+
+    p_client->rpc_buf       = req->base;
+    p_client->rpc_len       = req->len;
+    p_client->rpc_reply     = reply->base;
+    p_client->rpc_reply_len = reply->len;
+    p_client->rpc_peer      = tid;
+    p_client->rpc_status    = RTX_ERR;
+    KTRACE1(KTRACE_MSG_SEND, tid, req->len);
+
+    if (p_server->state == BLK_RECV) {
+        // server is already waiting, hand the request over and let it run
+        msg_deliver(p_server, p_client);
+        k_tsk_unblock(p_server);
+        k_tsk_block(BLK_REPLY);
+    } else {
+        wq_insert(&p_server->rpc_q, p_client);
+        k_tsk_block(BLK_CALL);
+    }
+
+    return p_client->rpc_status;
+}
+
+/**
+ * @brief   wait for a client's request
+ * @return  number of request bytes copied into buf, RTX_ERR on failure
+ * @note    the client stays blocked until msg_reply is called with sender_tid
+ */
+int k_msg_receive(task_t *sender_tid, void *buf, size_t len) {
+#ifdef DEBUG_0
+    printf("k_msg_receive: sender_tid = 0x%x, buf=0x%x, len=%d\r\n", sender_tid, buf, len);
+#endif /* DEBUG_0 */
+    TCB *p_server = gp_current_task;
+    TCB *p_client;
+
+    if (buf == NULL || len == 0) {
+        return RTX_ERR;
+    }
+
+    p_server->rpc_buf    = buf;
+    p_server->rpc_len    = len;
+    p_server->rpc_status = RTX_ERR;
+
+    p_client = wq_pop(&p_server->rpc_q);
+    if (p_client != NULL) {
+        msg_deliver(p_server, p_client);
+        p_client->state = BLK_REPLY;
+        KTRACE1(KTRACE_STATE, p_client->tid, BLK_REPLY);
+    } else {
+        k_tsk_block(BLK_RECV);
+    }
+    KTRACE1(KTRACE_MSG_RECV, p_server->rpc_peer, p_server->rpc_status);
+
+    if (sender_tid != NULL) {
+        *sender_tid = p_server->rpc_peer;
+    }
+    return p_server->rpc_status;
+}
+
+/**
+ * @brief   copy a reply into a blocked client's buffer and wake it up
+ * @return  RTX_OK on success, RTX_ERR if the client is not waiting on the caller
+ */
+int k_msg_reply(task_t client_tid, const void *buf, size_t len) {
+#ifdef DEBUG_0
+    printf("k_msg_reply: client_tid = %d, buf=0x%x, len=%d\r\n", client_tid, buf, len);
+#endif /* DEBUG_0 */
+    TCB *p_client;
+
+    if (client_tid >= MAX_TASKS) {
+        return RTX_ERR;
+    }
+
+    p_client = &g_tcbs[client_tid];
+    if (p_client->state != BLK_REPLY || p_client->rpc_peer != gp_current_task->tid) {
+        return RTX_ERR;
+    }
+
+    if (len > p_client->rpc_reply_len) {
+        len = p_client->rpc_reply_len;
+    }
+    p_client->rpc_status = (buf == NULL) ? 0 : msg_copy(p_client->rpc_reply, buf, len);
+    KTRACE1(KTRACE_MSG_REPLY, client_tid, p_client->rpc_status);
+    k_tsk_unblock(p_client);
+
+    if (check_prio() != RTX_OK) {
+        k_tsk_run_new();
+    }
+    return RTX_OK;
+}
+
+/**
+ * @brief   fail every call that is queued on or waiting for a reply from an exiting task
+ */
+void k_msg_exit(TCB *p_tcb) {
+    TCB *p_client;
+
+    while ((p_client = wq_pop(&p_tcb->rpc_q)) != NULL) {
+        p_client->rpc_status = RTX_ERR;
+        k_tsk_unblock(p_client);
+    }
+
+    for (int i = 1; i < MAX_TASKS; i++) {
+        p_client = &g_tcbs[i];
+        if (p_client->state == BLK_REPLY && p_client->rpc_peer == p_tcb->tid) {
+            p_client->rpc_status = RTX_ERR;
+            k_tsk_unblock(p_client);
+        }
+    }
+}
@@ -9,6 +9,7 @@
 #define K_MSG_H_
 
 #include "k_rtx.h"
+#include "common_ext.h"
 
 int k_mbx_create(size_t size);
 int k_send_msg(task_t receiver_tid, const void *buf);
@@ -16,4 +17,9 @@ int k_recv_msg(task_t *sender_tid, void *buf, size_t len);
 int k_recv_msg_nb(task_t *sender_tid, void *buf, size_t len);
 int k_mbx_ls(task_t *buf, int count);
 
+int k_msg_call(task_t tid, const RTX_IOV *req, RTX_IOV *reply);
+int k_msg_receive(task_t *sender_tid, void *buf, size_t len);
+int k_msg_reply(task_t client_tid, const void *buf, size_t len);
+void k_msg_exit(TCB *p_tcb);
+
 #endif /* ! K_MSG_H_ */
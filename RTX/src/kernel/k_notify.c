@@ -0,0 +1,138 @@
+/**
+ * @file:   k_notify.c
+ * @brief:  kernel direct to task notifications
+ * @date:   2021/03/11
+ *
+ * @note    Every task has a 32-bit notification word. Notifying updates the
+ *          word and, if the task is waiting for any of the bits now set,
+ *          puts it back on the ready queue; nothing is allocated or copied.
+ *          A bounded wait arms a kernel timeout on the timer wheel.
+ *          IRQ handlers notify through k_tsk_notify_irq, which leaves the
+ *          reschedule to the IRQ dispatcher.
+ */
+
+#include "k_notify.h"
+#include "k_timer.h"
+#include "k_crit.h"
+
+/**
+ * @brief   update the notification word of p_tcb and wake it if it waits for it
+ * @return  TRUE if the task was made ready
+ */
+static int notify(TCB *p_tcb, U32 bits, int mode)
+{
+    K_CRIT crit = k_crit_enter();          // a nested IRQ may notify the same task
+    int woken = FALSE;
+
+    if (mode == NOTIFY_SET_BITS) {
+        p_tcb->notify_val |= bits;
+    } else if (mode == NOTIFY_INCREMENT) {
+        p_tcb->notify_val++;
+    } else {
+        p_tcb->notify_val = bits;
+    }
+
+    if (p_tcb->state == BLK_NOTIFY && (p_tcb->notify_val & p_tcb->notify_mask) != 0) {
+        k_tsk_unblock(p_tcb);
+        woken = TRUE;
+    }
+    k_crit_exit(crit);
+    return woken;
+}
+
+static TCB *notify_target(task_t tid, int mode)
+{
+    if (tid == TID_NULL || tid >= MAX_TASKS || g_tcbs[tid].state == DORMANT || g_tcbs[tid].state == EXITING) {
+        return NULL;
+    }
+    if (mode != NOTIFY_SET_BITS && mode != NOTIFY_INCREMENT && mode != NOTIFY_OVERWRITE) {
+        return NULL;
+    }
+    return &g_tcbs[tid];
+}
+
+/**
+ * @brief   kernel timeout of a bounded tsk_wait_notify, runs in the tick IRQ
+ */
+static int notify_timeout(void *arg)
+{
+    TCB *p_tcb = arg;
+    K_CRIT crit = k_crit_enter();
+    int resched = FALSE;
+
+    p_tcb->wait_timer = RTX_ERR;            // the wheel already freed it
+    if (p_tcb->state == BLK_NOTIFY) {
+        k_tsk_unblock(p_tcb);
+        resched = (check_prio() != RTX_OK);
+    }
+    k_crit_exit(crit);
+    return resched;
+}
+
+/**
+ * @brief   tsk_notify syscall
+ * @return  RTX_OK on success, RTX_ERR if tid or mode is invalid
+ */
+int k_tsk_notify(task_t tid, U32 bits, int mode)
+{
+    TCB *p_tcb = notify_target(tid, mode);
+
+    if (p_tcb == NULL) {
+        return RTX_ERR;
+    }
+    if (notify(p_tcb, bits, mode) && check_prio() != RTX_OK) {
+        k_tsk_run_new();
+    }
+    return RTX_OK;
+}
+
+/**
+ * @brief   notify a task from an IRQ handler
+ * @return  TRUE if the notified task outranks the current one, for the
+ *          handler to pass back to the dispatcher; FALSE otherwise
+ */
+int k_tsk_notify_irq(task_t tid, U32 bits, int mode)
+{
+    TCB *p_tcb = notify_target(tid, mode);
+
+    if (p_tcb == NULL) {
+        return FALSE;
+    }
+    return notify(p_tcb, bits, mode) && check_prio() != RTX_OK;
+}
+
+/**
+ * @brief   tsk_wait_notify syscall, wait until a bit in mask is set
+ * @param   clear       clear the returned bits from the notification word
+ * @param   timeout_us  0 to poll, TIMEOUT_FOREVER to wait without a timeout
+ * @return  the bits of mask that are set, 0 if the wait timed out
+ */
+U32 k_tsk_wait_notify(U32 mask, int clear, U32 timeout_us)
+{
+    TCB *p_tcb = gp_current_task;
+    U32 bits;
+
+    if ((p_tcb->notify_val & mask) == 0 && timeout_us != 0 && mask != 0) {
+        p_tcb->notify_mask = mask;
+        if (timeout_us != TIMEOUT_FOREVER) {
+            p_tcb->wait_timer = k_timer_start(timeout_us, notify_timeout, p_tcb);
+            if (p_tcb->wait_timer == RTX_ERR) {
+                p_tcb->notify_mask = 0;
+                return 0;                   // no timer left to bound the wait
+            }
+        }
+        k_tsk_block(BLK_NOTIFY);
+
+        p_tcb->notify_mask = 0;
+        if (p_tcb->wait_timer != RTX_ERR) {
+            k_timer_cancel(p_tcb->wait_timer);  // woken by a notification
+            p_tcb->wait_timer = RTX_ERR;
+        }
+    }
+
+    bits = p_tcb->notify_val & mask;
+    if (clear) {
+        p_tcb->notify_val &= ~bits;
+    }
+    return bits;
+}
@@ -0,0 +1,15 @@
+/**
+ * @file:   k_notify.h
+ * @brief:  kernel direct to task notifications header file
+ * @date:   2021/03/11
+ */
+
+#ifndef K_NOTIFY_H_
+#define K_NOTIFY_H_
+
+#include "k_rtx.h"
+#include "common_ext.h"
+
+int k_tsk_notify_irq(task_t tid, U32 bits, int mode);
+
+#endif /* ! K_NOTIFY_H_ */
@@ -0,0 +1,182 @@
+/**
+ * @file:   k_pmu.c
+ * @brief:  per-task PMU event counters
+ * @date:   2021/03/20
+ *
+ * @note    A task picks the events its counters count with pmu_select,
+ *          and the counters are switched along with the task so every
+ *          task only sees its own events. k_tsk_run_new folds the
+ *          hardware counts of the task going out into its K_PMU_CTX and
+ *          programs the one coming in from zero. Tasks that never
+ *          selected an event cost a flag test on each side of a switch.
+ *          The cycle counter is never reset or stopped, IRQ accounting
+ *          and the event trace stamp with it, so a task's cycles are
+ *          summed from its readings at switch in and out instead. A
+ *          stint longer than one wrap of the 32 bit counters, seconds at
+ *          the A9's clock, loses whole wraps of cycles, the overflow
+ *          flags make up one wrap of each event counter.
+ *          IRQs taken while a task runs, and the switch itself, are
+ *          counted for the task.
+ */
+
+#include "k_pmu.h"
+#include "k_crit.h"
+#include "k_rq.h"
+#include "k_task.h"
+
+static K_PMU_CTX g_pmu[MAX_TASKS];      // indexed by tid, used once the TCB has pmu_on
+static U32       g_pmu_counters = 0;    // event counters both cores have, up to PMU_NUM_COUNTERS
+static U32       g_pmu_mask = 0;        // PMCNTENSET bits of those counters
+
+/**
+ * @brief   read the counters of the calling CPU into p_ctx, they keep running
+ * @pre     IRQs are masked, p_ctx belongs to the task running here
+ */
+static void pmu_save(K_PMU_CTX *p_ctx)
+{
+    U32 now = __get_PMCCNTR();
+    U32 ovf = __get_PMOVSR();
+
+    p_ctx->cycles += now - p_ctx->cycle_start;
+    p_ctx->cycle_start = now;
+    for (U32 n = 0; n < g_pmu_counters; n++) {
+        if (p_ctx->event[n] != PMU_EV_OFF) {
+            __set_PMSELR(n);
+            p_ctx->count[n] += __get_PMXEVCNTR();
+            if (ovf & (1U << n)) {
+                p_ctx->count[n] += 1ULL << 32;
+            }
+            __set_PMXEVCNTR(0);
+        }
+    }
+    __set_PMOVSR(g_pmu_mask);
+}
+
+/**
+ * @brief   program the events of p_ctx into the counters of the calling
+ *          CPU, counting from zero, and stop the counters it does not use
+ * @pre     IRQs are masked
+ */
+static void pmu_load(K_PMU_CTX *p_ctx)
+{
+    U32 mask = 0;
+
+    for (U32 n = 0; n < g_pmu_counters; n++) {
+        if (p_ctx->event[n] != PMU_EV_OFF) {
+            __set_PMSELR(n);
+            __set_PMXEVTYPER(p_ctx->event[n]);
+            __set_PMXEVCNTR(0);
+            mask |= 1U << n;
+        }
+    }
+    __set_PMCNTENCLR(g_pmu_mask & ~mask);
+    __set_PMOVSR(g_pmu_mask);
+    __set_PMCNTENSET(mask);
+    p_ctx->cycle_start = __get_PMCCNTR();
+}
+
+/**
+ * @brief   find out how many event counters the PMU has
+ * @pre     called on CPU 0 before the other cores are up, both cores have
+ *          the same PMU
+ */
+void k_pmu_init(void)
+{
+    g_pmu_counters = (__get_PMCR() >> 11) & 0x1F;      // PMCR.N
+    if (g_pmu_counters > PMU_NUM_COUNTERS) {
+        g_pmu_counters = PMU_NUM_COUNTERS;
+    }
+    g_pmu_mask = (1U << g_pmu_counters) - 1;
+}
+
+/**
+ * @brief   move the counters of this CPU from p_tcb_old to p_tcb_new
+ * @pre     IRQs are masked, called by k_tsk_run_new just before the switch
+ */
+void k_pmu_switch(TCB *p_tcb_old, TCB *p_tcb_new)
+{
+    if (p_tcb_old->pmu_on) {
+        pmu_save(&g_pmu[p_tcb_old->tid]);
+    }
+    if (p_tcb_new->pmu_on) {
+        pmu_load(&g_pmu[p_tcb_new->tid]);
+    } else if (p_tcb_old->pmu_on) {
+        __set_PMCNTENCLR(g_pmu_mask);
+    }
+}
+
+/**
+ * @brief   pmu_select syscall
+ * @param   counter 0 to PMU_NUM_COUNTERS - 1
+ * @param   event   PMU_EV_* or another A9 event number, PMU_EV_OFF to
+ *                  release the counter
+ * @return  RTX_OK on success, RTX_ERR if the PMU has no such counter or
+ *          event is not an event number
+ * @note    the first call starts the task's cycle count
+ */
+int k_pmu_select(U32 counter, U32 event)
+{
+    TCB *p_tcb = gp_current_task;
+    K_PMU_CTX *p_ctx = &g_pmu[p_tcb->tid];
+    K_CRIT crit;
+
+    if (counter >= g_pmu_counters || (event > 0xFF && event != PMU_EV_OFF)) {
+        return RTX_ERR;
+    }
+
+    crit = k_irq_save();
+    if (p_tcb->pmu_on) {
+        pmu_save(p_ctx);
+    } else {
+        p_ctx->cycles = 0;
+        for (U32 n = 0; n < PMU_NUM_COUNTERS; n++) {
+            p_ctx->count[n] = 0;
+            p_ctx->event[n] = PMU_EV_OFF;
+        }
+        p_tcb->pmu_on = TRUE;
+    }
+    p_ctx->event[counter] = (U16)event;
+    p_ctx->count[counter] = 0;
+    pmu_load(p_ctx);
+    k_irq_restore(crit);
+
+    return RTX_OK;
+}
+
+/**
+ * @brief   pmu_read syscall
+ * @return  RTX_OK on success, RTX_ERR if buf is NULL or tid is not a live task
+ * @note    the caller gets its counts up to now. Another task's counts
+ *          are as of its last switch out, a task running on the other
+ *          CPU is not interrupted for them. A task that never selected
+ *          an event reads as zeros with every counter PMU_EV_OFF.
+ */
+int k_pmu_read(task_t tid, RTX_PMU_COUNTS *buf)
+{
+    TCB *p_tcb;
+    K_PMU_CTX *p_ctx;
+    K_RQ *p_rq;
+
+    if (buf == NULL || tid >= MAX_TASKS || g_tcbs[tid].state == DORMANT) {
+        return RTX_ERR;
+    }
+    p_tcb = &g_tcbs[tid];
+    p_ctx = &g_pmu[tid];
+
+    if (p_tcb == gp_current_task && p_tcb->pmu_on) {
+        K_CRIT crit = k_irq_save();
+
+        pmu_save(p_ctx);
+        k_irq_restore(crit);
+    }
+
+    p_rq = k_rq_lock(p_tcb);            // keeps the switch path off p_ctx
+    buf->cycles = p_tcb->pmu_on ? p_ctx->cycles : 0;
+    for (U32 n = 0; n < PMU_NUM_COUNTERS; n++) {
+        buf->count[n] = p_tcb->pmu_on ? p_ctx->count[n] : 0;
+        buf->event[n] = p_tcb->pmu_on ? p_ctx->event[n] : PMU_EV_OFF;
+    }
+    k_rq_unlock(p_rq);
+
+    return RTX_OK;
+}
@@ -0,0 +1,28 @@
+/**
+ * @file:   k_pmu.h
+ * @brief:  per-task PMU event counters header file
+ * @date:   2021/03/20
+ */
+
+#ifndef K_PMU_H_
+#define K_PMU_H_
+
+#include "k_inc.h"
+#include "common_ext.h"
+
+/**
+ * @brief PMU state of one task, kept while the task is switched out
+ */
+typedef struct k_pmu_ctx {
+    U64     cycles;                     /* cycles run up to the last switch out */
+    U64     count[PMU_NUM_COUNTERS];    /* events up to the last switch out */
+    U16     event[PMU_NUM_COUNTERS];    /* PMU_EV_OFF for a counter not in use */
+    U32     cycle_start;                /* PMCCNTR when the task last got a CPU */
+} K_PMU_CTX;
+
+void k_pmu_init(void);
+void k_pmu_switch(TCB *p_tcb_old, TCB *p_tcb_new);
+int  k_pmu_select(U32 counter, U32 event);
+int  k_pmu_read(task_t tid, RTX_PMU_COUNTS *buf);
+
+#endif /* ! K_PMU_H_ */
@@ -0,0 +1,138 @@
+/**
+ * @file:   k_prof.c
+ * @brief:  PC-sampling profiler
+ * @date:   2021/03/21
+ *
+ * @note    While the profiler runs, HPS timer 1 interrupts CPU 0 every
+ *          sampling period. Its handler records where CPU 0 was
+ *          interrupted, in which mode and for which task, and asks every
+ *          other CPU for a sample of its own with IPI_SAMPLE. The PC is
+ *          read from the frame IRQ_Handler pushed, so a sample is the
+ *          exact resume address, handlers of lower priority included.
+ *          Code that runs with IRQs masked or under a GIC priority mask
+ *          cannot be interrupted, its time shows up at the first
+ *          instruction after it unmasks. A sample taken through the IPI
+ *          lands a little later than the timer's, still at a point the
+ *          CPU could be interrupted at.
+ *          Samples are reserved with LDREX/STREX like k_trace records.
+ *          When the buffer is full the rest are counted and dropped.
+ *          PROF_DUMP prints the buffer on the JTAG UART, and
+ *          tools/profile.py builds the flat and per-task profiles from
+ *          it or from a memory dump of g_kprof and the image's symbols.
+ */
+
+#include "k_prof.h"
+#include "k_irq.h"
+#include "k_ipi.h"
+#include "k_smp.h"
+#include "timer.h"
+#include "printf.h"
+
+KPROF_BUF g_kprof = { KPROF_MAGIC, NUM_CPUS, KPROF_BUF_SIZE };
+
+static volatile U32 g_kprof_on = FALSE;
+
+/**
+ * @brief   record where this CPU was interrupted
+ * @pre     called from an IRQ handler, k_irq_frame is the interrupted code
+ */
+void k_prof_sample(void)
+{
+    const U32 *frame = k_irq_frame();
+    KPROF_SAMPLE *p_smp;
+    U32 idx;
+
+    if (!g_kprof_on || frame == NULL) {
+        return;
+    }
+    do {
+        idx = __ldrex(&g_kprof.head);
+    } while (__strex(idx + 1, &g_kprof.head));
+    if (idx >= KPROF_BUF_SIZE) {
+        return;                             // dropped, head still counts it
+    }
+
+    p_smp = &g_kprof.sample[idx];
+    p_smp->mode = 0;                        // sample is being written
+    p_smp->pc   = frame[IRQ_FRAME_PC];
+    p_smp->cpu  = (U8)k_cpu_id();
+    p_smp->tid  = (gp_current_task == NULL) ? TID_NULL : gp_current_task->tid;
+    __dmb(0xF);                             // sample is complete before it is marked so
+    p_smp->mode = (U8)(frame[IRQ_FRAME_SPSR] & 0x1F);
+}
+
+/**
+ * @brief   HPS timer 1 handler, samples CPU 0 and has the others sample
+ */
+int k_prof_irq(U32 irq_id, void *arg)
+{
+    timer_clear_irq(1);
+    if (g_kprof_on) {
+        k_prof_sample();
+        for (U32 cpu = 0; cpu < NUM_CPUS; cpu++) {
+            if (cpu != k_cpu_id()) {
+                k_ipi_send(cpu, IPI_SAMPLE);
+            }
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * @brief   print the samples, oldest first
+ * @pre     sampling is stopped
+ */
+static void prof_dump(void)
+{
+    U32 head = g_kprof.head;
+    U32 kept = (head > KPROF_BUF_SIZE) ? KPROF_BUF_SIZE : head;
+
+    printf("kprof: begin cpus %u size %u period_us %u samples %u dropped %u\r\n",
+           g_kprof.num_cpus, g_kprof.buf_size, g_kprof.period_us, kept, head - kept);
+    for (U32 idx = 0; idx < kept; idx++) {
+        KPROF_SAMPLE *p_smp = &g_kprof.sample[idx];
+
+        if (p_smp->mode != 0) {
+            printf("kprof: %u %x %x %u\r\n", p_smp->cpu, p_smp->pc, p_smp->mode, p_smp->tid);
+        }
+    }
+    printf("kprof: end\r\n");
+}
+
+/**
+ * @brief   prof_ctl syscall
+ * @param   cmd         PROF_START, PROF_STOP or PROF_DUMP
+ * @param   period_us   sampling period for PROF_START, at least
+ *                      PROF_MIN_PERIOD_US
+ * @return  RTX_OK on success, RTX_ERR for an unknown command or a period
+ *          that is too short
+ * @note    entered without the kernel lock
+ */
+int k_prof_ctl(int cmd, U32 period_us)
+{
+    switch (cmd) {
+    case PROF_START:
+        if (period_us < PROF_MIN_PERIOD_US || period_us > 0xFFFFFFFF / HPS_TIMER_TICKS_PER_US) {
+            return RTX_ERR;
+        }
+        g_kprof_on = FALSE;
+        timer_disable(1);
+        g_kprof.head = 0;
+        g_kprof.period_us = period_us;
+        __dmb(0xF);
+        g_kprof_on = TRUE;
+        config_hps_timer(1, period_us * HPS_TIMER_TICKS_PER_US, 1, 0);
+        return RTX_OK;
+    case PROF_STOP:
+        g_kprof_on = FALSE;
+        timer_disable(1);
+        return RTX_OK;
+    case PROF_DUMP:
+        g_kprof_on = FALSE;
+        timer_disable(1);
+        prof_dump();
+        return RTX_OK;
+    default:
+        return RTX_ERR;
+    }
+}
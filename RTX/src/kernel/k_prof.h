@@ -0,0 +1,45 @@
+/**
+ * @file:   k_prof.h
+ * @brief:  PC-sampling profiler header file
+ * @date:   2021/03/21
+ */
+
+#ifndef K_PROF_H_
+#define K_PROF_H_
+
+#include "k_inc.h"
+#include "common_ext.h"
+
+#define KPROF_BUF_SIZE      8192        /* samples kept, later ones are only counted */
+#define KPROF_MAGIC         0x464F5250  /* "PROF", first word of a memory dump */
+
+/**
+ * @brief one sample, mode is written last and is never 0 once it is valid
+ */
+typedef struct kprof_sample {
+    U32             pc;                 /* where the interrupted code resumes */
+    volatile U8     mode;               /* CPSR mode it ran in, 0 while being written */
+    U8              cpu;
+    task_t          tid;                /* task running on that CPU */
+    U8              pad;
+} KPROF_SAMPLE;
+
+/**
+ * @brief everything a memory dump of g_kprof needs to be decoded
+ */
+typedef struct kprof_buf {
+    U32             magic;              /* KPROF_MAGIC */
+    U32             num_cpus;
+    U32             buf_size;           /* KPROF_BUF_SIZE */
+    U32             period_us;          /* sampling period of the last PROF_START */
+    volatile U32    head;               /* samples taken, the ones past buf_size were dropped */
+    KPROF_SAMPLE    sample[KPROF_BUF_SIZE];
+} KPROF_BUF;
+
+extern KPROF_BUF g_kprof;
+
+int  k_prof_irq(U32 irq_id, void *arg);
+void k_prof_sample(void);
+int  k_prof_ctl(int cmd, U32 period_us);
+
+#endif /* ! K_PROF_H_ */
@@ -0,0 +1,286 @@
+/**
+ * @file:   k_rq.c
+ * @brief:  kernel per-CPU ready queues
+ * @date:   2021/03/16
+ *
+ * @note    Each CPU schedules from its own queue under the queue's
+ *          spinlock, so yields on different cores do not meet. A task is
+ *          queued on tcb->cpu, a CPU with nothing to run steals the best
+ *          task queued elsewhere, and the tick moves a task from the
+ *          longest queue to the shortest every RQ_BALANCE_TICKS.
+ *          Lock order is the kernel lock before any queue lock, and a
+ *          second queue lock is only tried, or taken in index order.
+ *          A task only runs on the CPUs in tcb->affinity. A CPU skips
+ *          queued tasks it may not run, which only happens with RQ_GLOBAL
+ *          or right after a running task lost its CPU, and the tick moves
+ *          those to a queue they may run from.
+ *          A task queued for another CPU that outranks what that CPU runs
+ *          makes it reschedule with an IPI, see k_rq_kick.
+ */
+
+#include "k_rq.h"
+#include "k_task.h"
+#include "k_smp.h"
+#include "k_ipi.h"
+
+K_RQ g_rq[NUM_RQS];
+
+/**
+ * @brief   lock the queue p_tcb is on, or would be put on
+ * @pre     IRQs are masked
+ * @note    looks again after locking, a steal may have moved the task
+ */
+K_RQ *k_rq_lock(TCB *p_tcb)
+{
+    while (1) {
+        K_RQ *p_rq = k_rq_of(p_tcb->cpu);
+
+        k_spin_lock(&p_rq->lock);
+        if (p_rq == k_rq_of(p_tcb->cpu)) {
+            return p_rq;
+        }
+        k_spin_unlock(&p_rq->lock);
+    }
+}
+
+void k_rq_unlock(K_RQ *p_rq)
+{
+    k_spin_unlock(&p_rq->lock);
+}
+
+/**
+ * @brief   the online CPU in affinity with the fewest queued tasks, for a
+ *          new or woken task
+ * @note    a task none of whose CPUs is online yet waits on the queue of
+ *          this CPU, which never runs it, until one comes up and steals it
+ */
+U32 k_rq_pick_cpu(U8 affinity)
+{
+    U32 best = k_cpu_id();
+    int found = (affinity >> best) & 1;
+
+    for (U32 cpu = 0; cpu < NUM_CPUS; cpu++) {
+        if (!g_cpu_online[cpu] || !((affinity >> cpu) & 1)) {
+            continue;
+        }
+        if (!found || k_rq_of(cpu)->nr < k_rq_of(best)->nr) {
+            best = cpu;
+            found = TRUE;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief   the first task on p_rq that may run on cpu, or the null task
+ *          that ends the queue
+ */
+static TCB *rq_first(K_RQ *p_rq, U32 cpu)
+{
+    TCB *p_tcb = p_rq->head;
+
+    while (p_tcb->next != NULL && !k_rq_allowed(p_tcb, cpu)) {
+        p_tcb = p_tcb->next;
+    }
+    return p_tcb;
+}
+
+/**
+ * @brief   the task cpu would run next from its own queue
+ * @note    the head of the queue unless it holds tasks pinned elsewhere
+ */
+TCB *k_rq_first(U32 cpu)
+{
+    return rq_first(k_rq_of(cpu), cpu);
+}
+
+/**
+ * @brief   TRUE if another queue has a task cpu could steal
+ * @note    reads without locks, for the null task to poll, so it only
+ *          looks at the head of each queue
+ */
+int k_rq_can_steal(U32 cpu)
+{
+    for (U32 i = 0; i < NUM_RQS; i++) {
+        if (&g_rq[i] != k_rq_of(cpu) && g_rq[i].nr != 0 && k_rq_allowed(g_rq[i].head, cpu)) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * @brief   take the highest priority task queued on another CPU that may
+ *          run on cpu
+ * @pre     the queue of cpu is locked, IRQs are masked
+ * @return  the task, now belonging to cpu, or NULL
+ */
+TCB *k_rq_steal(U32 cpu)
+{
+    K_RQ *p_from = NULL;
+    TCB *p_best = NULL;
+
+    for (U32 i = 0; i < NUM_RQS; i++) {
+        K_RQ *p_rq = &g_rq[i];
+        TCB *p_tcb;
+
+        // a busy lock means that CPU is scheduling anyway, do not wait on it
+        if (p_rq == k_rq_of(cpu) || p_rq->nr == 0 || !k_spin_trylock(&p_rq->lock)) {
+            continue;
+        }
+        p_tcb = rq_first(p_rq, cpu);
+        if (p_tcb->next != NULL && (p_best == NULL || p_tcb->prio < p_best->prio)) {
+            if (p_from != NULL) {
+                k_spin_unlock(&p_from->lock);
+            }
+            p_from = p_rq;
+            p_best = p_tcb;
+        } else {
+            k_spin_unlock(&p_rq->lock);
+        }
+    }
+    if (p_from == NULL) {
+        return NULL;
+    }
+
+    l_pop(p_best);
+    p_best->cpu = cpu;
+    k_spin_unlock(&p_from->lock);
+    return p_best;
+}
+
+/**
+ * @brief   change the CPUs a task may run on
+ * @param   mask    non-zero mask of existing CPUs
+ * @note    a READY task is moved now, a blocked one when it wakes and a
+ *          running one when its CPU switches it out
+ */
+void k_rq_set_affinity(TCB *p_tcb, U8 mask)
+{
+    K_CRIT crit = k_irq_save();
+    K_RQ *p_rq = k_rq_lock(p_tcb);
+
+    p_tcb->affinity = mask;
+    if (p_tcb->state == READY && !k_rq_allowed(p_tcb, p_tcb->cpu)) {
+        l_pop(p_tcb);
+        k_rq_unlock(p_rq);
+        p_tcb->cpu = k_rq_pick_cpu(mask);
+        p_rq = k_rq_lock(p_tcb);
+        l_insert(p_tcb);
+        k_rq_unlock(p_rq);
+        k_rq_kick(p_tcb);
+    } else {
+        k_rq_unlock(p_rq);
+        if (p_tcb->state == RUNNING && p_tcb->cpu != k_cpu_id() && !k_rq_allowed(p_tcb, p_tcb->cpu)) {
+            k_ipi_send(p_tcb->cpu, IPI_RESCHED);   // switch it out so it can move
+        }
+    }
+    k_irq_restore(crit);
+}
+
+/**
+ * @brief   move the tasks queued on a CPU they may not run on
+ * @pre     every queue is locked
+ */
+static void rq_fix_affinity(void)
+{
+    for (U32 i = 0; i < NUM_RQS; i++) {
+        TCB *p_tcb = g_rq[i].head;         // NULL until the CPU is brought up
+
+        while (p_tcb != NULL && p_tcb->next != NULL) {
+            TCB *p_next = p_tcb->next;
+            U32 cpu = k_rq_pick_cpu(p_tcb->affinity);
+
+            if (!k_rq_allowed(p_tcb, i) && k_rq_allowed(p_tcb, cpu)) {
+                l_pop(p_tcb);
+                p_tcb->cpu = cpu;
+                l_insert(p_tcb);
+            }
+            p_tcb = p_next;
+        }
+    }
+}
+
+/**
+ * @brief   move the lowest priority task of the longest queue to the
+ *          shortest one when they differ by two or more, after moving any
+ *          task queued on a CPU it may not run on
+ * @note    called from the tick
+ */
+void k_rq_balance(void)
+{
+    K_CRIT crit;
+    U32 busy = 0;
+    U32 idle = 0;
+
+    if (NUM_RQS == 1) {
+        return;
+    }
+
+    crit = k_irq_save();
+    for (U32 i = 0; i < NUM_RQS; i++) {
+        k_spin_lock(&g_rq[i].lock);
+    }
+    rq_fix_affinity();
+    for (U32 i = 1; i < NUM_RQS; i++) {
+        if (g_rq[i].nr > g_rq[busy].nr) {
+            busy = i;
+        }
+        if (g_cpu_online[i] && g_rq[i].nr < g_rq[idle].nr) {
+            idle = i;
+        }
+    }
+    if (g_rq[busy].nr >= g_rq[idle].nr + 2) {
+        TCB *p_move = NULL;
+
+        // the last one before the null task that may run on idle
+        for (TCB *p_tcb = g_rq[busy].head; p_tcb->next != NULL; p_tcb = p_tcb->next) {
+            if (k_rq_allowed(p_tcb, idle)) {
+                p_move = p_tcb;
+            }
+        }
+        if (p_move != NULL) {
+            l_pop(p_move);
+            p_move->cpu = idle;
+            l_insert(p_move);
+        }
+    }
+    for (U32 i = NUM_RQS; i > 0; i--) {
+        k_spin_unlock(&g_rq[i - 1].lock);
+    }
+    // a CPU that was given work may be running its null task
+    for (U32 cpu = 0; cpu < NUM_CPUS; cpu++) {
+        if (cpu != k_cpu_id() && g_cpu_online[cpu] && k_rq_first(cpu)->prio < g_cur_task[cpu]->prio) {
+            k_ipi_send(cpu, IPI_RESCHED);
+        }
+    }
+    k_irq_restore(crit);
+}
+
+/**
+ * @brief   make the CPU that should run p_tcb now reschedule
+ * @note    call after p_tcb was queued, the calling CPU is left out since
+ *          it checks for itself with check_prio. Reads the running tasks
+ *          without locks, a CPU that switches meanwhile picks from its
+ *          queue anyway, so the worst case is one needless IPI.
+ */
+void k_rq_kick(TCB *p_tcb)
+{
+    U32 target = NUM_CPUS;
+
+    for (U32 cpu = 0; cpu < NUM_CPUS; cpu++) {
+        TCB *p_cur = g_cur_task[cpu];
+
+        if (cpu == k_cpu_id() || p_cur == NULL || !g_cpu_online[cpu] ||
+            k_rq_of(cpu) != k_rq_of(p_tcb->cpu) || !k_rq_allowed(p_tcb, cpu)) {
+            continue;
+        }
+        // with RQ_GLOBAL every CPU shares the queue, preempt the lowest
+        if (p_tcb->prio < p_cur->prio && (target == NUM_CPUS || p_cur->prio > g_cur_task[target]->prio)) {
+            target = cpu;
+        }
+    }
+    if (target != NUM_CPUS) {
+        k_ipi_send(target, IPI_RESCHED);
+    }
+}
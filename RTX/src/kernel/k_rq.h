@@ -0,0 +1,48 @@
+/**
+ * @file:   k_rq.h
+ * @brief:  kernel per-CPU ready queues header file
+ * @date:   2021/03/16
+ */
+
+#ifndef K_RQ_H_
+#define K_RQ_H_
+
+#include "k_inc.h"
+#include "k_crit.h"
+
+/* build with RQ_GLOBAL to schedule every CPU from one shared queue */
+#ifdef RQ_GLOBAL
+#define NUM_RQS             1
+#define RQ_CPU(cpu)         0
+#else
+#define NUM_RQS             NUM_CPUS
+#define RQ_CPU(cpu)         (cpu)
+#endif
+
+#define RQ_BALANCE_TICKS    100         /* HPS timer0 ticks between rebalancing, 10 ms */
+
+#define CPU_MASK_ALL        ((1U << NUM_CPUS) - 1)
+#define k_rq_mask(aff)      (((aff) & CPU_MASK_ALL) ? ((aff) & CPU_MASK_ALL) : CPU_MASK_ALL)
+#define k_rq_allowed(p_tcb, cpu)    (((p_tcb)->affinity >> (cpu)) & 1)
+
+typedef struct k_rq {
+    K_SPINLOCK      lock;
+    TCB            *head;               /* priority ordered, ends with the null task of the CPU */
+    U32             nr;                 /* tasks queued, the null task not counted */
+} K_RQ;
+
+extern K_RQ g_rq[NUM_RQS];
+
+#define k_rq_of(cpu)        (&g_rq[RQ_CPU(cpu)])
+
+K_RQ *k_rq_lock(TCB *p_tcb);
+void  k_rq_unlock(K_RQ *p_rq);
+U32   k_rq_pick_cpu(U8 affinity);
+TCB  *k_rq_first(U32 cpu);
+void  k_rq_set_affinity(TCB *p_tcb, U8 mask);
+int   k_rq_can_steal(U32 cpu);
+TCB  *k_rq_steal(U32 cpu);
+void  k_rq_balance(void);
+void  k_rq_kick(TCB *p_tcb);
+
+#endif /* ! K_RQ_H_ */
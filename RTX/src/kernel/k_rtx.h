@@ -44,7 +44,20 @@
 #include "k_rtx_init.h"
 #include "k_task.h"
 #include "k_mem.h"
-//#include "k_msg.h" // lab3
+#include "k_msg.h"
+#include "k_topic.h"
+#include "k_irq.h"
+#include "k_crit.h"
+#include "k_smp.h"
+#include "k_rq.h"
+#include "k_ipi.h"
+#include "k_time.h"
+#include "k_timer.h"
+#include "k_notify.h"
+#include "k_sem.h"
+#include "k_trace.h"
+#include "k_pmu.h"
+#include "k_prof.h"
 #endif /* ! K_RTX_H_ */
 /*
  *===========================================================================
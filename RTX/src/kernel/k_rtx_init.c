@@ -43,16 +43,61 @@
 #include "Serial.h"
 #include "k_mem.h"
 #include "k_task.h"
+#include "k_irq.h"
+#include "k_uart.h"
+#include "k_time.h"
+#include "k_timer.h"
+#include "k_log.h"
+#include "k_smp.h"
+#include "k_rq.h"
+#include "k_ipi.h"
+#include "k_trace.h"
+
+/* HPS timer0 tick, drives the software timers, rebalances the ready queues and logs roughly every half second */
+static int k_timer0_irq(U32 irq_id, void *arg)
+{
+    static U64 time_last = 0;
+    static U32 ticks = 0;
+    U64 time_curr;
+    int resched;
+
+    timer_clear_irq(0);
+    resched = k_timer_tick();
+    if (++ticks % RQ_BALANCE_TICKS == 0) {
+        k_rq_balance();
+    }
+    time_curr = k_get_time_us();
+    if ((time_curr - time_last) > 500000U) {
+        KLOG1(KLOG_TIMER0_MS, (U32)(time_curr - time_last)/1000U);
+        time_last = time_curr;
+    }
+    return resched;
+}
 
 int k_rtx_init(RTX_TASK_INFO *task_info, int num_tasks)
 {
+    // Route the board interrupts through the dispatch table
+    k_irq_init();
+    k_irq_register(UART0_Rx_IRQ_ID, k_uart_irq, NULL);
+    k_irq_register(HPS_TIMER0_IRQ_ID, k_timer0_irq, NULL);
+    k_irq_register(HPS_TIMER1_IRQ_ID, k_prof_irq, NULL);
+    k_ipi_init();
+    // the tick preempts UART handling
+    GIC_SetPriority(HPS_TIMER0_IRQ_ID, HPS_TIMER0_IRQ_PRIO);
+    GIC_SetPriority(UART0_Rx_IRQ_ID, UART0_IRQ_PRIO);
+    GIC_SetPriority(HPS_TIMER1_IRQ_ID, HPS_TIMER1_IRQ_PRIO);
+
     // Initialize UART0 Rx interrupts
     UART0_Init();
-    // Set HPS0 timer to count down from
-    config_hps_timer(0,10000,1,0);
-    // Set A9 timer to count down from 0xFFFFFFFF every 1 us
+    // Set HPS0 timer to interrupt every 100 us, the board timer.h gives the count
+    config_hps_timer(0,HPS_TIMER0_TICK_COUNT,1,0);
+    // Set A9 timer to count down from 0xFFFFFFFF every 1 us, k_cpu_main does the same on the other cores
     // With this setting, A9 timer resets every ~1.2 hrs
-    config_a9_timer(0xFFFFFFFF,1,0,199);
+    config_a9_timer(0xFFFFFFFF,1,0,A9_TIMER_PRESCALER_US);
+    // The 64 bit global timer is shared by the cores, k_get_time_us and task run times are taken from it
+    config_global_timer(0);
+    k_trace_init();
+    k_pmu_init();
 
     /* interrupts are already disabled when we enter here */
     if ( k_mem_init() != RTX_OK) {
@@ -62,6 +107,9 @@ int k_rtx_init(RTX_TASK_INFO *task_info, int num_tasks)
     if ( k_tsk_init(task_info, num_tasks) != RTX_OK ) {
         return RTX_ERR;
     }
+
+    // let the other cores in, they start as their null tasks
+    k_smp_init();
     
     /* start the first task */
     //return k_tsk_start();
@@ -0,0 +1,355 @@
+/**
+ * @file:   k_sem.c
+ * @brief:  kernel semaphores, mutexes and ceiling resources
+ * @date:   2021/03/13
+ *
+ * @note    Both keep their waiters in priority order. A release hands the
+ *          count or the mutex straight to the first waiter, so a task that
+ *          runs in between cannot take it away.
+ *          A mutex owner runs at the best priority of its base priority and
+ *          the first waiter of every mutex it holds. Blocking on a mutex
+ *          pushes the waiter's priority down the chain of owners that are
+ *          themselves blocked on mutexes. Unlocking or tsk_set_prio works
+ *          out the priority again from the mutexes still held.
+ *          A ceiling resource never queues anyone. Taking it raises the
+ *          holder to the ceiling right away, so no task that could also take
+ *          it gets to run until it is released. Resources must be released
+ *          in the reverse order they were taken, and a holder must not block.
+ *          The ceiling only keeps out tasks of the holder's own CPU, so a
+ *          resource belongs to one CPU. The first task to take it binds it
+ *          to the CPU it is pinned to, and only tasks pinned to that CPU may
+ *          take it after that. A holder cannot change its affinity.
+ */
+
+#include "k_sem.h"
+#include "k_crit.h"
+
+static K_SEM   g_sems[MAX_SEMS];
+static K_MUTEX g_mutexes[MAX_MUTEXES];
+static K_RES   g_res[MAX_RESOURCES];
+
+static K_SEM *sem_get(int sem)
+{
+    if (sem < 0 || sem >= MAX_SEMS || !g_sems[sem].in_use) {
+        return NULL;
+    }
+    return &g_sems[sem];
+}
+
+static K_MUTEX *mutex_get(int mutex)
+{
+    if (mutex < 0 || mutex >= MAX_MUTEXES || !g_mutexes[mutex].in_use) {
+        return NULL;
+    }
+    return &g_mutexes[mutex];
+}
+
+static K_RES *res_get(int res)
+{
+    if (res < 0 || res >= MAX_RESOURCES || !g_res[res].in_use) {
+        return NULL;
+    }
+    return &g_res[res];
+}
+
+/**
+ * @brief   create a counting semaphore
+ * @return  semaphore id on success, RTX_ERR on failure
+ */
+int k_sem_create(int count)
+{
+    if (count < 0) {
+        return RTX_ERR;
+    }
+    for (int i = 0; i < MAX_SEMS; i++) {
+        if (!g_sems[i].in_use) {
+            g_sems[i].in_use = 1;
+            g_sems[i].count = count;
+            g_sems[i].wq = NULL;
+            return i;
+        }
+    }
+    return RTX_ERR;
+}
+
+/**
+ * @brief   take one count, blocking until a post hands one over
+ */
+int k_sem_wait(int sem)
+{
+    K_SEM *p_sem = sem_get(sem);
+    K_CRIT crit;
+
+    if (p_sem == NULL) {
+        return RTX_ERR;
+    }
+    crit = k_crit_enter();
+    if (p_sem->count > 0) {
+        p_sem->count--;
+    } else {
+        wq_insert(&p_sem->wq, gp_current_task);
+        k_tsk_block(BLK_SEM);               // the count is handed to us by k_sem_post
+    }
+    k_crit_exit(crit);
+    return RTX_OK;
+}
+
+/**
+ * @brief   give one count to the highest priority waiter, or keep it if none
+ */
+int k_sem_post(int sem)
+{
+    K_SEM *p_sem = sem_get(sem);
+    TCB *p_tcb;
+    K_CRIT crit;
+
+    if (p_sem == NULL) {
+        return RTX_ERR;
+    }
+    crit = k_crit_enter();
+    p_tcb = wq_pop(&p_sem->wq);
+    if (p_tcb == NULL) {
+        p_sem->count++;
+    } else {
+        k_tsk_unblock(p_tcb);
+        if (check_prio() != RTX_OK) {
+            k_tsk_run_new();
+        }
+    }
+    k_crit_exit(crit);
+    return RTX_OK;
+}
+
+/**
+ * @brief   create an unlocked mutex
+ * @return  mutex id on success, RTX_ERR on failure
+ */
+int k_mutex_create(void)
+{
+    for (int i = 0; i < MAX_MUTEXES; i++) {
+        if (!g_mutexes[i].in_use) {
+            g_mutexes[i].in_use = 1;
+            g_mutexes[i].owner = NULL;
+            g_mutexes[i].wq = NULL;
+            g_mutexes[i].next_held = NULL;
+            return i;
+        }
+    }
+    return RTX_ERR;
+}
+
+/**
+ * @brief   the priority p_tcb should run at, the best of its base priority,
+ *          the ceiling of the resources it holds and the highest priority
+ *          task waiting on a mutex it holds
+ */
+U8 k_mutex_prio(TCB *p_tcb)
+{
+    U8 prio = p_tcb->base_prio;
+
+    if (p_tcb->res_held != NULL && p_tcb->res_held->ceiling < prio) {
+        prio = p_tcb->res_held->ceiling;    // the last one taken has the highest ceiling
+    }
+
+    for (K_MUTEX *p_mutex = p_tcb->held; p_mutex != NULL; p_mutex = p_mutex->next_held) {
+        if (p_mutex->wq != NULL && p_mutex->wq->prio < prio) {
+            prio = p_mutex->wq->prio;
+        }
+    }
+    return prio;
+}
+
+/**
+ * @brief   bring the owner of p_mutex, and the owners it is blocked behind,
+ *          to the priority their waiters call for
+ * @note    stops at the first owner whose priority does not change
+ */
+void k_mutex_propagate(K_MUTEX *p_mutex)
+{
+    while (p_mutex != NULL && p_mutex->owner != NULL) {
+        TCB *p_owner = p_mutex->owner;
+        U8 prio = k_mutex_prio(p_owner);
+
+        if (prio == p_owner->prio) {
+            break;
+        }
+        k_tsk_reprio(p_owner, prio);
+        p_mutex = (p_owner->state == BLK_MUTEX) ? p_owner->blk_mutex : NULL;
+    }
+}
+
+static void mutex_take(K_MUTEX *p_mutex, TCB *p_tcb)
+{
+    p_mutex->owner = p_tcb;
+    p_mutex->next_held = p_tcb->held;
+    p_tcb->held = p_mutex;
+}
+
+/**
+ * @brief   release p_mutex from its owner and hand it to the first waiter
+ * @return  TRUE if a waiter was made ready
+ */
+static int mutex_give(K_MUTEX *p_mutex)
+{
+    TCB *p_owner = p_mutex->owner;
+    TCB *p_next;
+    K_MUTEX **pp_held = &p_owner->held;
+
+    while (*pp_held != p_mutex) {
+        pp_held = &(*pp_held)->next_held;
+    }
+    *pp_held = p_mutex->next_held;
+    p_mutex->next_held = NULL;
+    p_mutex->owner = NULL;
+
+    p_next = wq_pop(&p_mutex->wq);
+    if (p_next != NULL) {
+        p_next->blk_mutex = NULL;
+        mutex_take(p_mutex, p_next);
+        k_tsk_reprio(p_next, k_mutex_prio(p_next));     // it may now inherit from the rest of the queue
+        k_tsk_unblock(p_next);
+    }
+    k_tsk_reprio(p_owner, k_mutex_prio(p_owner));       // drop what it inherited through this mutex
+    return p_next != NULL;
+}
+
+/**
+ * @brief   lock a mutex, blocking until the owner hands it over
+ * @return  RTX_OK on success, RTX_ERR if the mutex is invalid or already
+ *          held by the caller
+ */
+int k_mutex_lock(int mutex)
+{
+    K_MUTEX *p_mutex = mutex_get(mutex);
+    TCB *p_tcb = gp_current_task;
+    K_CRIT crit;
+
+    if (p_mutex == NULL || p_mutex->owner == p_tcb) {
+        return RTX_ERR;
+    }
+    crit = k_crit_enter();
+    if (p_mutex->owner == NULL) {
+        mutex_take(p_mutex, p_tcb);
+    } else {
+        p_tcb->blk_mutex = p_mutex;
+        wq_insert(&p_mutex->wq, p_tcb);
+        k_mutex_propagate(p_mutex);
+        k_tsk_block(BLK_MUTEX);             // the mutex is handed to us by k_mutex_unlock
+    }
+    k_crit_exit(crit);
+    return RTX_OK;
+}
+
+/**
+ * @brief   unlock a mutex held by the caller
+ */
+int k_mutex_unlock(int mutex)
+{
+    K_MUTEX *p_mutex = mutex_get(mutex);
+    K_CRIT crit;
+
+    if (p_mutex == NULL || p_mutex->owner != gp_current_task) {
+        return RTX_ERR;
+    }
+    crit = k_crit_enter();
+    mutex_give(p_mutex);
+    if (check_prio() != RTX_OK) {
+        k_tsk_run_new();
+    }
+    k_crit_exit(crit);
+    return RTX_OK;
+}
+
+/**
+ * @brief   create a priority ceiling resource
+ * @param   ceiling: highest priority of any task that will take it
+ * @return  resource id on success, RTX_ERR on failure
+ */
+int k_res_create(U8 ceiling)
+{
+    if (ceiling == PRIO_KERNEL || ceiling > LOWEST) {
+        return RTX_ERR;
+    }
+    for (int i = 0; i < MAX_RESOURCES; i++) {
+        if (!g_res[i].in_use) {
+            g_res[i].in_use = 1;
+            g_res[i].ceiling = ceiling;
+            g_res[i].cpu = RES_CPU_NONE;
+            g_res[i].owner = NULL;
+            g_res[i].next_held = NULL;
+            return i;
+        }
+    }
+    return RTX_ERR;
+}
+
+/**
+ * @brief   take a resource and run at its ceiling until it is released
+ * @return  RTX_OK on success, RTX_ERR if the resource is invalid or held,
+ *          the caller already runs above the ceiling, or the caller is not
+ *          pinned to the CPU of the resource
+ * @note    never blocks. A task running above the ceiling breaks the
+ *          protocol, and a held resource can only be seen that way too.
+ */
+int k_res_acquire(int res)
+{
+    K_RES *p_res = res_get(res);
+    TCB *p_tcb = gp_current_task;
+    U8 cpu = p_tcb->cpu;
+
+    if (p_res == NULL || p_res->owner != NULL || p_tcb->prio < p_res->ceiling) {
+        return RTX_ERR;
+    }
+    if (p_tcb->affinity != AFFINITY_CPU(cpu) || (p_res->cpu != RES_CPU_NONE && p_res->cpu != cpu)) {
+        return RTX_ERR;                     // a holder on another CPU is not kept out by the ceiling
+    }
+    p_res->cpu = cpu;
+    p_res->owner = p_tcb;
+    p_res->next_held = p_tcb->res_held;
+    p_tcb->res_held = p_res;
+    p_tcb->prio = p_res->ceiling;           // the running task is not on the ready queue
+    return RTX_OK;
+}
+
+/**
+ * @brief   release the resource the caller took last
+ * @return  RTX_OK on success, RTX_ERR if the resource is invalid or not the
+ *          one the caller took last
+ */
+int k_res_release(int res)
+{
+    TCB *p_tcb = gp_current_task;
+    K_RES *p_res = res_get(res);
+    K_CRIT crit;
+
+    if (p_res == NULL || p_res != p_tcb->res_held) {
+        return RTX_ERR;
+    }
+    p_tcb->res_held = p_res->next_held;
+    p_res->next_held = NULL;
+    p_res->owner = NULL;
+    crit = k_crit_enter();
+    p_tcb->prio = k_mutex_prio(p_tcb);
+    if (check_prio() != RTX_OK) {
+        k_tsk_run_new();
+    }
+    k_crit_exit(crit);
+    return RTX_OK;
+}
+
+/**
+ * @brief   hand over the mutexes and resources of an exiting task
+ */
+void k_sem_exit(TCB *p_tcb)
+{
+    while (p_tcb->res_held != NULL) {
+        K_RES *p_res = p_tcb->res_held;
+
+        p_tcb->res_held = p_res->next_held;
+        p_res->next_held = NULL;
+        p_res->owner = NULL;
+    }
+    while (p_tcb->held != NULL) {
+        mutex_give(p_tcb->held);
+    }
+}
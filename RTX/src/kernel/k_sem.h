@@ -0,0 +1,43 @@
+/**
+ * @file:   k_sem.h
+ * @brief:  kernel semaphores, mutexes and ceiling resources header file
+ * @date:   2021/03/13
+ */
+
+#ifndef K_SEM_H_
+#define K_SEM_H_
+
+#include "k_rtx.h"
+#include "common_ext.h"
+
+#define MAX_SEMS            32      /* semaphores in the system */
+#define MAX_MUTEXES         32      /* mutexes in the system */
+#define MAX_RESOURCES       32      /* priority ceiling resources in the system */
+#define RES_CPU_NONE        0xFF    /* resource not bound to a CPU yet */
+
+typedef struct k_sem {
+    U8              in_use;
+    int             count;
+    TCB            *wq;             /* tasks blocked in sem_wait, highest priority first */
+} K_SEM;
+
+typedef struct k_mutex {
+    U8              in_use;
+    TCB            *owner;          /* NULL while unlocked */
+    TCB            *wq;             /* tasks blocked in mutex_lock, highest priority first */
+    struct k_mutex *next_held;      /* next mutex held by the same owner */
+} K_MUTEX;
+
+typedef struct k_res {
+    U8              in_use;
+    U8              ceiling;        /* priority every holder runs at */
+    U8              cpu;            /* CPU every taker is pinned to, bound by the first one */
+    TCB            *owner;          /* NULL while free */
+    struct k_res   *next_held;      /* resource the owner took before this one */
+} K_RES;
+
+U8   k_mutex_prio(TCB *p_tcb);
+void k_mutex_propagate(K_MUTEX *p_mutex);
+void k_sem_exit(TCB *p_tcb);
+
+#endif /* ! K_SEM_H_ */
@@ -0,0 +1,117 @@
+/**
+ * @file:   k_smp.c
+ * @brief:  kernel multiprocessor bring-up
+ * @date:   2021/03/15
+ *
+ * @note    Reset_Handler parks every core but CPU 0 until k_smp_init hands
+ *          it an SVC stack through g_cpu_boot_sp. The core then sets up its
+ *          own exception mode stacks and GIC CPU interface and becomes the
+ *          null task of that CPU. CPU 0 keeps TID_NULL, which also ends the
+ *          ready queue, the other CPUs get a null task of their own that is
+ *          never queued.
+ *          Each null task ends the ready queue of its CPU, see k_rq.c.
+ */
+
+#include "k_smp.h"
+#include "k_crit.h"
+#include "k_task.h"
+#include "k_rq.h"
+#include "k_ipi.h"
+#include "interrupt.h"
+#include "system_a9.h"
+#include "timer.h"
+
+K_KLOCK g_klock = { 0, KLOCK_NO_OWNER, 0 };
+
+volatile U32 g_cpu_boot_sp[NUM_CPUS];   // read by Reset_Handler, 0 keeps the core parked
+volatile U32 g_cpu_online[NUM_CPUS] = { TRUE };    // set once the CPU runs its null task
+
+static const U8 g_null_tid[NUM_CPUS] = { TID_NULL, TID_NULL_CPU1 };
+
+/**
+ * @brief   the null task of the calling CPU
+ */
+TCB *k_smp_null_task(void)
+{
+    return &g_tcbs[g_null_tid[k_cpu_id()]];
+}
+
+/**
+ * @brief   SVC_Handler calls this before the kernel function
+ * @param   site    the kernel function, kept as the IRQs-off call site
+ * @param   svc     SVC number of the trap, SVC_KLOCK or SVC_NOLOCK
+ * @pre     IRQs are masked
+ * @note    A syscall is declared with __svc_indirect(1) when it must not
+ *          run under the kernel lock, like tsk_yield, which only needs
+ *          the ready queue of this CPU, or mem_alloc, which takes the
+ *          lock itself when its CPU's magazine cannot serve it.
+ */
+void k_svc_enter(U32 site, U32 svc)
+{
+    k_irqoff_enter(site);
+    if (svc == SVC_KLOCK) {
+        k_klock_acquire();
+    }
+}
+
+/**
+ * @brief   SVC_Handler calls this after the kernel function returns
+ * @note    the kernel function leaves the lock as it found it, so this CPU
+ *          owns it exactly when k_svc_enter took it
+ */
+void k_svc_exit(void)
+{
+    if (g_klock.owner == k_cpu_id()) {
+        k_klock_release();
+    }
+    k_irqoff_exit();
+}
+
+/**
+ * @brief   create the null tasks of the other CPUs and let the cores run
+ * @pre     k_tsk_init is done, called on CPU 0 with IRQs masked
+ */
+void k_smp_init(void)
+{
+    for (U32 cpu = 1; cpu < NUM_CPUS; cpu++) {
+        U8 tid = g_null_tid[cpu];
+        TCB *p_tcb = &g_tcbs[tid];
+
+        // runs straight on its kernel stack from Reset_Handler, no initial frame
+        initialize_tcb(p_tcb, NULL, NULL, PRIO_NULL, 1, RUNNING, task_null_cpu, tid, 0, NULL);
+        p_tcb->cpu = cpu;
+        p_tcb->affinity = AFFINITY_CPU(cpu);
+        if (k_rq_of(cpu)->head == NULL) {
+            k_rq_of(cpu)->head = p_tcb;     // with RQ_GLOBAL the queue already ends with TID_NULL
+        }
+        g_num_active_tasks++;
+        g_cpu_boot_sp[cpu] = (U32)&g_k_stacks[tid + 1];
+    }
+    __dsb(0xF);
+    for (U32 cpu = 1; cpu < NUM_CPUS; cpu++) {
+        SystemReleaseCPU(cpu);
+    }
+    __sev();
+}
+
+/**
+ * @brief   C entry of the cores other than CPU 0
+ * @note    called by Reset_Handler on the SVC stack set by k_smp_init,
+ *          with IRQs masked and the exception mode stacks set up
+ */
+void k_cpu_main(void)
+{
+    U32 cpu = k_cpu_id();
+
+    GIC_CPUInterfaceInit();             // the CPU interface is banked per core
+    __enable_PMCCNTR();                 // so is the PMU, IRQ accounting and traces read it
+    config_a9_timer(0xFFFFFFFF,1,0,A9_TIMER_PRESCALER_US);     // and the A9 timer, free running as on CPU 0
+    k_ipi_cpu_init();
+    gp_current_task = &g_tcbs[g_null_tid[cpu]];
+    gp_current_task->run_start = global_timer_get_val();
+    __dmb(0xF);
+    g_cpu_online[cpu] = TRUE;
+
+    __enable_irq();
+    task_null_cpu();
+}
@@ -0,0 +1,25 @@
+/**
+ * @file:   k_smp.h
+ * @brief:  kernel multiprocessor bring-up header file
+ * @date:   2021/03/15
+ */
+
+#ifndef K_SMP_H_
+#define K_SMP_H_
+
+#include "k_inc.h"
+#include "common_ext.h"
+
+#define SVC_KLOCK       0       /* trap runs the kernel function under the kernel lock */
+#define SVC_NOLOCK      1       /* the kernel function takes the locks it needs itself */
+
+extern volatile U32 g_cpu_boot_sp[NUM_CPUS];
+extern volatile U32 g_cpu_online[NUM_CPUS];
+
+void k_smp_init(void);
+void k_cpu_main(void);
+TCB *k_smp_null_task(void);
+void k_svc_enter(U32 site, U32 svc);
+void k_svc_exit(void);
+
+#endif /* ! K_SMP_H_ */
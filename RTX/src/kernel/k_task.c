@@ -63,12 +63,13 @@
  *==========================================================================
  */
 
-TCB             *gp_current_task = NULL;	// the current RUNNING task
+TCB             *g_cur_task[NUM_CPUS];		// the current RUNNING task of each CPU
 TCB             g_tcbs[MAX_TASKS];			// an array of TCBs
 RTX_TASK_INFO   g_null_task_info;			// The null task info
 U32             g_num_active_tasks = 0;		// number of non-dormant tasks
+static TCB     *g_tsk_exited[NUM_CPUS];		// task that exited on each CPU, its stacks are in use until the switch
 
-TCB 			*task_q_head = NULL;		// Head for task queue
+// the ready queues are per CPU, see k_rq.c
 
 /*---------------------------------------------------------------------------
 The memory map of the OS image may look like the following:
@@ -140,23 +141,26 @@ The memory map of the OS image may look like the following:
 
 TCB *scheduler(void)
 {
-    TCB *temp_tcb = task_q_head;
+    U32 cpu = k_cpu_id();
+    TCB *temp_tcb = k_rq_of(cpu)->head;
     // Case 1: pop head
-	if (temp_tcb->state == READY)
+	if (temp_tcb->state == READY && k_rq_allowed(temp_tcb, cpu))
 	{
 		// make sure not to pop NULL task
 		if (temp_tcb->next != NULL)
 		{
 			l_pop(temp_tcb);
+			return temp_tcb;
 		}
-		return temp_tcb;
+		temp_tcb = k_rq_steal(cpu);
+		return (temp_tcb != NULL) ? temp_tcb : k_smp_null_task();
 	}
 
-	// Search for next non-dormant task
+	// Search for next non-dormant task this CPU may run
 	while (temp_tcb->next != NULL)
 	{
 		// Case 2: pop from middle
-		if (temp_tcb->state == READY)
+		if (temp_tcb->state == READY && k_rq_allowed(temp_tcb, cpu))
 		{
 			l_pop(temp_tcb);
 			return temp_tcb;
@@ -164,8 +168,9 @@ TCB *scheduler(void)
 		temp_tcb = temp_tcb->next;
 	}
 
-	// Case 3: return NULL task
-	return temp_tcb;
+	// Case 3: take work queued on another CPU, or run the NULL task of this CPU
+	temp_tcb = k_rq_steal(cpu);
+	return (temp_tcb != NULL) ? temp_tcb : k_smp_null_task();
 }
 
 
@@ -197,6 +202,7 @@ int k_tsk_init(RTX_TASK_INFO *task_info, int num_tasks)
     // create the first task
     TCB *p_tcb = &g_tcbs[0];
     p_tcb->prio     = PRIO_NULL;
+    p_tcb->base_prio = PRIO_NULL;
     p_tcb->priv     = 1;
     p_tcb->tid      = TID_NULL;
     p_tcb->state    = RUNNING;
@@ -204,7 +210,9 @@ int k_tsk_init(RTX_TASK_INFO *task_info, int num_tasks)
     p_tcb->task_entry = task_null;
     g_num_active_tasks++;
     gp_current_task = p_tcb;
-    task_q_head = p_tcb;
+    p_tcb->cpu      = 0;
+    p_tcb->affinity = AFFINITY_CPU(0);
+    k_rq_of(0)->head = p_tcb;
 
 
     // create the rest of the tasks
@@ -220,10 +228,18 @@ int k_tsk_init(RTX_TASK_INFO *task_info, int num_tasks)
         }
         p_taskinfo++;
     }
-    for (int i = num_tasks; i < MAX_TASKS; i++) {
-    	TCB *p_tcb = &g_tcbs[i+1];
+    for (int i = num_tasks + 1; i < MAX_TASKS; i++) {
+    	TCB *p_tcb = &g_tcbs[i];
     	p_tcb->state = DORMANT;
     }
+
+    // kernel worker for interrupt bottom halves, see k_irq_defer
+    task_t worker_tid = TID_IRQ_WORKER;
+    RTX_TASK_INFO worker_info;
+    initialize_rtx_task_info(&worker_info, NULL, task_irq_worker, IRQ_WORKER_PRIO, &worker_tid, 0, 1, READY);
+    if (k_tsk_create_new(&worker_info, &g_tcbs[TID_IRQ_WORKER], TID_IRQ_WORKER) == RTX_OK) {
+    	g_num_active_tasks++;
+    }
     return RTX_OK;
 }
 /**************************************************************************//**
@@ -239,13 +255,13 @@ int k_tsk_init(RTX_TASK_INFO *task_info, int num_tasks)
  *              we have user initial context (xPSR, PC, SP_USR, uR0-uR12)
  *              then we stack up the kernel initial context (kLR, kR0-kR12)
  *              The PC is the entry point of the user task
- *              The kLR is set to SVC_RESTORE
+ *              The kLR is set to k_tsk_entry, kR4 to SVC_EXIT
  *              30 registers in total
  *
  *****************************************************************************/
 int k_tsk_create_new(RTX_TASK_INFO *p_taskinfo, TCB *p_tcb, task_t tid)
 {
-    extern U32 SVC_RESTORE;
+    extern U32 SVC_EXIT;
 
     U32 *sp;
 
@@ -254,7 +270,8 @@ int k_tsk_create_new(RTX_TASK_INFO *p_taskinfo, TCB *p_tcb, task_t tid)
         return RTX_ERR;
     }
 	initialize_tcb(p_tcb, NULL, NULL, p_taskinfo->prio, p_taskinfo->priv, p_taskinfo->state, p_taskinfo->ptask, tid, p_taskinfo->u_stack_size, p_taskinfo->u_stack_hi);
-	l_insert(p_tcb);
+	p_tcb->affinity = k_rq_mask(p_taskinfo->affinity);
+	p_tcb->cpu = k_rq_pick_cpu(p_tcb->affinity);
     /*---------------------------------------------------------------
      *  Step1: allocate kernel stack for the task
      *         stacks grows down, stack base is at the high address
@@ -307,29 +324,38 @@ int k_tsk_create_new(RTX_TASK_INFO *p_taskinfo, TCB *p_tcb, task_t tid)
      *         14 registers listed in push order
      *         <kLR, kR0-kR12>
      * -------------------------------------------------------------*/
-    if ( p_taskinfo->priv == 0 ) {
-        // user thread LR: return to the SVC handler
-        *(--sp) = (U32) (&SVC_RESTORE);
-    } else {
-        // kernel thread LR: return to the entry point of the task
-        *(--sp) = (U32) (p_taskinfo->ptask);
-    }
-
-    // kernel stack R0 - R12, 13 registers
-    for ( int j = 0; j < 13; j++) {
-        *(--sp) = 0x0;
+    // LR: k_tsk_entry drops the kernel lock held across the switch and
+    // jumps to R4, the SVC handler exit for a user thread or the entry
+    // point of a kernel thread
+    *(--sp) = (U32) (&k_tsk_entry);
+
+    // kernel stack R12 - R0, 13 registers
+    for ( int j = 12; j >= 0; j--) {
+        if (j == 4) {
+            *(--sp) = (p_taskinfo->priv == 0) ? (U32) (&SVC_EXIT) : (U32) (p_taskinfo->ptask);
+        } else {
+            *(--sp) = 0x0;
+        }
     }
 
-    // kernel stack CPSR
-    *(--sp) = (U32) INIT_CPSR_SVC;
+    // kernel stack CPSR, IRQs stay masked until k_tsk_entry
+    *(--sp) = (U32) (INIT_CPSR_SVC | CPSR_I_BIT);
     p_tcb->ksp = sp;
 
+    // only now can another CPU pick the task and switch to its frames
+    K_RQ *p_rq = k_rq_lock(p_tcb);
+    l_insert(p_tcb);
+    k_rq_unlock(p_rq);
+    k_rq_kick(p_tcb);
+    KTRACE1(KTRACE_STATE, tid, p_tcb->state);
+
     return RTX_OK;
 }
 
 /**************************************************************************//**
  * @brief       switching kernel stacks of two TCBs
  * @param:      p_tcb_old, the old tcb that was in RUNNING
+ * @param:      p_tcb_new, the tcb to run, gp_current_task of this CPU
  * @return:     RTX_OK upon success
  *              RTX_ERR upon failure
  * @pre:        gp_current_task is pointing to a valid TCB
@@ -343,57 +369,160 @@ int k_tsk_create_new(RTX_TASK_INFO *p_taskinfo, TCB *p_tcb, task_t tid)
  * !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
  *
  *****************************************************************************/
-__asm void k_tsk_switch(TCB *p_tcb_old)
+__asm void k_tsk_switch(TCB *p_tcb_old, TCB *p_tcb_new)
 {
         PUSH    {R0-R12, LR}
-        MRS 	R1, CPSR
-        PUSH 	{R1}
+        MRS 	R2, CPSR
+        PUSH 	{R2}
         STR     SP, [R0, #TCB_KSP_OFFSET]   ; save SP to p_old_tcb->ksp
-        LDR     R1, =__cpp(&gp_current_task);
-        LDR     R2, [R1]
-        LDR     SP, [R2, #TCB_KSP_OFFSET]   ; restore ksp of the gp_current_task
+        LDR     SP, [R1, #TCB_KSP_OFFSET]   ; restore ksp of p_tcb_new, the gp_current_task
         POP		{R0}
         MSR		CPSR_cxsf, R0
         POP     {R0-R12, PC}
 }
 
+/**************************************************************************//**
+ * @brief       first code a new task runs after k_tsk_switch
+ * @pre         R4 holds where the task starts, SVC_EXIT or its entry point
+ *****************************************************************************/
+__asm void k_tsk_entry(void)
+{
+        PRESERVE8
+        IMPORT  k_tsk_start
+        BL      k_tsk_start                 ; R4 is callee saved
+        BX      R4
+}
 
 /**************************************************************************//**
- * @brief       run a new thread. The caller becomes READY and
- *              the scheduler picks the next ready to run task.
- * @return      RTX_ERR on error and zero on success
- * @pre         gp_current_task != NULL && gp_current_task == RUNNING
- * @post        gp_current_task gets updated to next to run task
- * !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
- * @attention   CRITICAL SECTION
- * !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+ * @brief       free the TCB of a task that exited on this CPU, once the
+ *              switch away from it saved its context and left its stack
+ * @pre         the ready queue of this CPU is locked, called right after
+ *              k_tsk_switch
  *****************************************************************************/
-int k_tsk_run_new(void)
+static void tsk_reap(void)
+{
+	TCB *p_tcb = g_tsk_exited[k_cpu_id()];
+
+	if (p_tcb != NULL) {
+		g_tsk_exited[k_cpu_id()] = NULL;
+		__dmb(0xF);						// ksp is stored before tsk_create may pick the tid
+		p_tcb->state = DORMANT;
+	}
+}
+
+/**************************************************************************//**
+ * @brief       finish the switch k_tsk_run_new started a new task with
+ * @note        a new task holds no kernel lock
+ *****************************************************************************/
+void k_tsk_start(void)
+{
+	tsk_reap();
+	k_spin_unlock(&k_rq_of(k_cpu_id())->lock);
+	k_irq_restore(0);					// the CPSR k_tsk_run_new was entered with is gone, unmask
+}
+
+/**
+ * @brief       charge the stint p_tcb_old just had to it and start timing
+ *              p_tcb_new, IRQs taken meanwhile are charged to the task
+ * @pre         the ready queue of this CPU is locked
+ */
+static void tsk_account(TCB *p_tcb_old, TCB *p_tcb_new)
+{
+	U64 now = global_timer_get_val();
+
+	p_tcb_old->run_time += now - p_tcb_old->run_start;
+	p_tcb_new->run_start = now;
+}
+
+/**************************************************************************//**
+ * @brief       k_tsk_run_new, dropping p_unlock once the ready queue is locked
+ * @note        a waker that takes p_unlock before it looks at the caller's
+ *              state then cannot unblock it until the switch is done
+ *****************************************************************************/
+static int tsk_run_new(K_SPINLOCK *p_unlock)
 {
     TCB *p_tcb_old = NULL;
+    K_CRIT crit;
+    K_RQ *p_rq;
     
     if (gp_current_task == NULL) {
     	return RTX_ERR;
     }
 
+    crit = k_irq_save();
+    p_rq = k_rq_of(k_cpu_id());
+    k_spin_lock(&p_rq->lock);
+    if (p_unlock != NULL) {
+    	k_spin_unlock(p_unlock);
+    }
     p_tcb_old = gp_current_task;
+
+    // a steal since the caller looked may have left nothing better to run,
+    // unless the caller may no longer run on this CPU
+    if (p_tcb_old->state == RUNNING && k_rq_allowed(p_tcb_old, k_cpu_id()) &&
+    	k_rq_first(k_cpu_id())->prio > p_tcb_old->prio) {
+    	k_spin_unlock(&p_rq->lock);
+    	k_irq_restore(crit);
+    	return RTX_OK;
+    }
 	gp_current_task = scheduler();
 
 	if (gp_current_task != p_tcb_old) {
-		gp_current_task->state = RUNNING;
-		if (gp_current_task->tid == TID_NULL) {
-			task_null();
+		if (p_tcb_old->state == RUNNING) {
+			p_tcb_old->nivcsw++;
+		} else {
+			p_tcb_old->nvcsw++;
 		}
-		if (p_tcb_old->state != DORMANT) {
+		gp_current_task->state = RUNNING;
+		gp_current_task->cpu = k_cpu_id();	// with RQ_GLOBAL it may have last run elsewhere
+		// a blocked or exiting task stays off the ready queue, one that
+		// lost this CPU is queued here until the tick or a steal moves it
+		if (p_tcb_old->state == RUNNING) {
 			p_tcb_old->state = READY;			// change state of the to-be-switched-out tcb
-			l_insert(p_tcb_old);
+			if (p_tcb_old->prio != PRIO_NULL) {	// null tasks never leave their queue
+				l_insert(p_tcb_old);
+			}
+		}
+		// the queue stays locked across the switch, so no other CPU can
+		// pick or wake p_tcb_old before its context is saved. The task
+		// that runs next unlocks it, the kernel lock is dropped meanwhile.
+		tsk_account(p_tcb_old, gp_current_task);
+		k_pmu_switch(p_tcb_old, gp_current_task);
+		// an exiting task still runs on its kernel stack, the next one frees it
+		if (p_tcb_old->state == EXITING) {
+			g_tsk_exited[k_cpu_id()] = p_tcb_old;
 		}
-		k_tsk_switch(p_tcb_old);
+		p_tcb_old->klock_depth = k_klock_drop();
+		KTRACE1(KTRACE_SWITCH, p_tcb_old->tid, p_tcb_old->state);
+		k_tsk_switch(p_tcb_old, gp_current_task);
+
+		// p_tcb_old runs again here, maybe on another CPU
+		tsk_reap();
+		k_spin_unlock(&k_rq_of(k_cpu_id())->lock);
+		k_klock_retake(p_tcb_old->klock_depth);
+	} else {
+		k_spin_unlock(&p_rq->lock);
 	}
+	k_irq_restore(crit);
 
 	return RTX_OK;
 }
 
+/**************************************************************************//**
+ * @brief       run a new thread. The caller becomes READY and
+ *              the scheduler picks the next ready to run task.
+ * @return      RTX_ERR on error and zero on success
+ * @pre         gp_current_task != NULL && gp_current_task == RUNNING
+ * @post        gp_current_task gets updated to next to run task
+ * !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+ * @attention   CRITICAL SECTION
+ * !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+ *****************************************************************************/
+int k_tsk_run_new(void)
+{
+	return tsk_run_new(NULL);
+}
+
 /**************************************************************************//**
  * @brief       yield the cpu
  * @return:     RTX_OK upon success
@@ -405,12 +534,70 @@ int k_tsk_run_new(void)
  *****************************************************************************/
 int k_tsk_yield(void)
 {
+	// no kernel lock, only this CPU's ready queue is involved
+	K_CRIT crit = k_irq_save();
+	int ret = RTX_OK;
+
 	if (check_strict_prio() != RTX_OK) {
-		return k_tsk_run_new();
+		ret = k_tsk_run_new();
 	}
-	return RTX_OK;
+	k_irq_restore(crit);
+	return ret;
+}
+
+
+/**************************************************************************//**
+ * @brief       block the running task and run the next ready task
+ * @param       state   the blocked state the caller waits in
+ * @pre         the caller has queued gp_current_task wherever its waker looks
+ * @post        returns once another task or an IRQ calls k_tsk_unblock
+ *****************************************************************************/
+void k_tsk_block(U8 state)
+{
+	K_CRIT crit = k_crit_enter();
+
+	gp_current_task->state = state;
+	k_tsk_run_new();
+	k_crit_exit(crit);
 }
 
+/**************************************************************************//**
+ * @brief       block the running task without the kernel lock, for a waker
+ *              that runs in IRQ context and only takes p_lock
+ * @param       state   the blocked state the caller waits in
+ * @param       p_lock  held by the caller with IRQs masked, the waker takes
+ *                      it before it looks at the state
+ * @post        p_lock is free, returns once the waker calls k_tsk_unblock
+ *****************************************************************************/
+void k_tsk_block_on(U8 state, K_SPINLOCK *p_lock)
+{
+	gp_current_task->state = state;
+	tsk_run_new(p_lock);
+}
+
+/**************************************************************************//**
+ * @brief       make a blocked task ready to run again
+ * @param       p_tcb   the blocked task
+ * @note        does not preempt the caller, see check_prio
+ *              masks IRQs itself since a nested IRQ handler may also wake tasks
+ *****************************************************************************/
+void k_tsk_unblock(TCB *p_tcb)
+{
+	K_CRIT crit = k_irq_save();
+	K_RQ *p_rq;
+
+	if (!k_rq_allowed(p_tcb, p_tcb->cpu)) {
+		p_tcb->cpu = k_rq_pick_cpu(p_tcb->affinity);
+	}
+	p_rq = k_rq_lock(p_tcb);			// back on the CPU it last ran on
+
+	p_tcb->state = READY;
+	l_insert(p_tcb);
+	k_rq_unlock(p_rq);
+	k_rq_kick(p_tcb);
+	KTRACE1(KTRACE_STATE, p_tcb->tid, READY);
+	k_irq_restore(crit);
+}
 
 /*
  *===========================================================================
@@ -421,7 +608,7 @@ int k_tsk_yield(void)
 
 int check_strict_prio() {
 	TCB *p_tcb_current = gp_current_task;
-	TCB *p_tcb_next = task_q_head;
+	TCB *p_tcb_next = k_rq_first(k_cpu_id());
 	if (p_tcb_current->prio < p_tcb_next->prio) {
 		return RTX_OK;
 	}
@@ -430,7 +617,7 @@ int check_strict_prio() {
 
 int check_prio() {
 	TCB *p_tcb_current = gp_current_task;
-	TCB *p_tcb_next = task_q_head;
+	TCB *p_tcb_next = k_rq_first(k_cpu_id());
 	if (p_tcb_current->prio <= p_tcb_next->prio) {
 		return RTX_OK;
 	}
@@ -457,12 +644,28 @@ void initialize_rtx_task_info(RTX_TASK_INFO *buffer, U32 u_stack_hi, void (*task
 	buffer->prio = prio;
 	buffer->state = state;
 	buffer->priv = priv;
+	buffer->affinity = AFFINITY_ANY;
 
 }
 
 void initialize_tcb(TCB *tcb, U32 *ksp, TCB *next, U8 prio, U8 priv, U8 state, void (*task_entry)(void), U8 tid, U16 stack_size, U32 u_stack_hi) {
 	tcb->ksp = ksp;
 	tcb->next = NULL;
+	tcb->wait_next = NULL;
+	tcb->wait_q = NULL;
+	tcb->base_prio = prio;
+	tcb->blk_mutex = NULL;
+	tcb->held = NULL;
+	tcb->res_held = NULL;
+	tcb->klock_depth = 0;
+	tcb->run_time = 0;
+	tcb->run_start = 0;
+	tcb->nvcsw = 0;
+	tcb->nivcsw = 0;
+	tcb->pmu_on = FALSE;
+	tcb->notify_val = 0;
+	tcb->notify_mask = 0;
+	tcb->wait_timer = RTX_ERR;
 	tcb->prio = prio;
 	tcb->priv = priv;
 	tcb->state = state;
@@ -471,23 +674,28 @@ void initialize_tcb(TCB *tcb, U32 *ksp, TCB *next, U8 prio, U8 priv, U8 state, v
 	tcb->u_stack_size = stack_size;
 	tcb->u_stack_hi = u_stack_hi;
 }
-int k_tsk_create(task_t *task, void (*task_entry)(void), U8 prio, U16 stack_size)
+static int tsk_create(task_t *task, void (*task_entry)(void), U8 prio, U16 stack_size, U8 affinity)
 {
-#ifdef DEBUG_0
-    //printf("k_tsk_create: entering...\n\r");
-    //printf("task = 0x%x, task_entry = 0x%x, prio=%d, stack_size = %d\n\r", task, task_entry, prio, stack_size);
-#endif /* DEBUG_0 */
-
-	if (prio == PRIO_NULL || prio == PRIO_RT || stack_size < U_STACK_SIZE || stack_size % 8  != 0 || task == NULL || task_entry == NULL || g_num_active_tasks >= MAX_TASKS) {
+	if (prio == PRIO_NULL || prio == PRIO_RT || prio == PRIO_KERNEL || stack_size < U_STACK_SIZE || stack_size % 8  != 0 || task == NULL || task_entry == NULL || g_num_active_tasks >= MAX_TASKS) {
+		return RTX_ERR;
+	}
+	if ((affinity & ~CPU_MASK_ALL) != 0) {
 		return RTX_ERR;
 	}
+
+	K_CRIT crit = k_crit_enter();
 	*task = get_next_available_tid();
+	if (*task == TID_NULL) {				// the free TCBs are still being switched away from
+		k_crit_exit(crit);
+		return RTX_ERR;
+	}
 
 	TCB *tcb = &g_tcbs[*task];
 	RTX_TASK_INFO rtx_task_info_temp;
 
 	U32 user_stack_hi_addr = (U32) k_alloc_p_stack(tcb, *task, stack_size);
 	initialize_rtx_task_info(&rtx_task_info_temp, user_stack_hi_addr, task_entry, prio, task, stack_size, 0, READY);
+	rtx_task_info_temp.affinity = affinity;
 
 	k_tsk_create_new(&rtx_task_info_temp, tcb, *task);
 	g_num_active_tasks++;
@@ -495,24 +703,52 @@ int k_tsk_create(task_t *task, void (*task_entry)(void), U8 prio, U16 stack_size
 	if (check_prio() != RTX_OK) {
 		k_tsk_run_new();
 	}
-
+	k_crit_exit(crit);
 
 	return RTX_OK;
+}
 
+int k_tsk_create(task_t *task, void (*task_entry)(void), U8 prio, U16 stack_size)
+{
+#ifdef DEBUG_0
+    //printf("k_tsk_create: entering...\n\r");
+    //printf("task = 0x%x, task_entry = 0x%x, prio=%d, stack_size = %d\n\r", task, task_entry, prio, stack_size);
+#endif /* DEBUG_0 */
+
+	return tsk_create(task, task_entry, prio, stack_size, AFFINITY_ANY);
+}
 
+/**************************************************************************//**
+ * @brief       create a task from the ptask, prio, u_stack_size and
+ *              affinity fields of info, the other fields are ignored
+ * @return      RTX_OK on success, RTX_ERR on failure
+ *****************************************************************************/
+int k_tsk_create_ex(task_t *task, const RTX_TASK_INFO *info)
+{
+	if (info == NULL) {
+		return RTX_ERR;
+	}
+	return tsk_create(task, info->ptask, info->prio, info->u_stack_size, info->affinity);
 }
 
 void k_tsk_exit(void) 
 {
+    k_crit_enter();                     // never returns, the next task restores its own mask
 
+    // not DORMANT yet, tsk_create could hand out the tid while we still run on its stack
     if (gp_current_task != NULL){
-    	gp_current_task->state = DORMANT;
+    	gp_current_task->state = EXITING;
     }
 
     if (gp_current_task->priv == 0) {
     	k_mem_dealloc((void*)gp_current_task->u_stack_lo);
     }
 
+    k_msg_exit(gp_current_task);
+    k_topic_exit(gp_current_task);
+    k_timer_exit(gp_current_task);
+    k_sem_exit(gp_current_task);
+
     g_num_active_tasks--;
     k_tsk_run_new();
 
@@ -529,23 +765,54 @@ int k_tsk_set_prio(task_t task_id, U8 prio)
 	if (prio <= PRIO_RT || prio >= PRIO_NULL || task_id <= TID_NULL || task_id >= MAX_TASKS) {
 		return RTX_ERR;
 	}
+	// PRIO_KERNEL is kept for the IRQ worker, which may be put back there
+	if (prio == PRIO_KERNEL && task_id != TID_IRQ_WORKER) {
+		return RTX_ERR;
+	}
 
 	TCB* target_task = &g_tcbs[task_id];
-
-	if ((gp_current_task->priv == 1 || target_task->priv == 0) && target_task->state != DORMANT){
-		target_task->prio = prio;
+	K_CRIT crit = k_crit_enter();
+
+	if ((gp_current_task->priv == 1 || target_task->priv == 0) && target_task->state != DORMANT && target_task->state != EXITING){
+		target_task->base_prio = prio;
+		// a task holding a mutex keeps the priority it inherited from the waiters
+		k_tsk_reprio(target_task, k_mutex_prio(target_task));
+		if (target_task->state == BLK_MUTEX) {
+			k_mutex_propagate(target_task->blk_mutex);
+		}
 		if ((gp_current_task->tid == target_task->tid && check_strict_prio()) ||
 			(gp_current_task->tid != target_task->tid && check_prio())) {
 			k_tsk_run_new();
 		}
-
+		k_crit_exit(crit);
 		return RTX_OK;
 	}
-
+	k_crit_exit(crit);
 
     return RTX_ERR;
 }
 
+/**
+ * @brief       copy the run time statistics of p_tcb into buffer, a running
+ *              task is charged for its stint so far
+ * @note        the ready queue lock of p_tcb keeps the switch path from
+ *              changing them meanwhile
+ */
+static void tsk_get_stats(TCB *p_tcb, RTX_TASK_INFO *buffer)
+{
+	K_RQ *p_rq = k_rq_lock(p_tcb);
+	U64 run_time = p_tcb->run_time;
+
+	if (p_tcb->state == RUNNING) {
+		run_time += global_timer_get_val() - p_tcb->run_start;
+	}
+	buffer->run_time_us = run_time / GLOBAL_TIMER_TICKS_PER_US;
+	buffer->last_run_us = p_tcb->run_start / GLOBAL_TIMER_TICKS_PER_US;
+	buffer->nvcsw = p_tcb->nvcsw;
+	buffer->nivcsw = p_tcb->nivcsw;
+	k_rq_unlock(p_rq);
+}
+
 int k_tsk_get_info(task_t task_id, RTX_TASK_INFO *buffer)
 {
 #ifdef DEBUG_0
@@ -561,11 +828,58 @@ int k_tsk_get_info(task_t task_id, RTX_TASK_INFO *buffer)
     /* The code fills the buffer with some fake task information. 
        You should fill the buffer with correct information    */
 
-    initialize_rtx_task_info(buffer, foundTCB->u_stack_hi, foundTCB->task_entry, foundTCB->prio, &task_id, foundTCB->u_stack_size, foundTCB->priv, foundTCB->state);
+    initialize_rtx_task_info(buffer, foundTCB->u_stack_hi, foundTCB->task_entry, foundTCB->base_prio, &task_id, foundTCB->u_stack_size, foundTCB->priv, foundTCB->state);
+    buffer->affinity = foundTCB->affinity;
+    tsk_get_stats(foundTCB, buffer);
 
     return RTX_OK;     
 }
 
+/**************************************************************************//**
+ * @brief       limit a task to the CPUs in mask, AFFINITY_ANY lifts the limit
+ * @return      RTX_OK on success, RTX_ERR if the task is dormant or a null
+ *              task, mask names a CPU that does not exist, an
+ *              unprivileged caller targets a privileged task, or the task
+ *              holds a ceiling resource and mask would move it
+ *****************************************************************************/
+int k_tsk_set_affinity(task_t task_id, U8 mask)
+{
+	if (task_id <= TID_NULL || task_id >= MAX_TASKS || (mask & ~CPU_MASK_ALL) != 0) {
+		return RTX_ERR;
+	}
+
+	TCB *target_task = &g_tcbs[task_id];
+	K_CRIT crit = k_crit_enter();
+
+	if (target_task->state == DORMANT || target_task->state == EXITING || target_task->base_prio == PRIO_NULL ||
+		(gp_current_task->priv == 0 && target_task->priv == 1) ||
+		(target_task->res_held != NULL && k_rq_mask(mask) != target_task->affinity)) {
+		k_crit_exit(crit);
+		return RTX_ERR;				// a ceiling resource holder stays on the CPU of the resource
+	}
+	k_rq_set_affinity(target_task, k_rq_mask(mask));
+
+	// the caller leaves a CPU it lost right away, and a task moved here may
+	// outrank it
+	if (!k_rq_allowed(gp_current_task, k_cpu_id()) || check_prio() != RTX_OK) {
+		k_tsk_run_new();
+	}
+	k_crit_exit(crit);
+	return RTX_OK;
+}
+
+/**************************************************************************//**
+ * @brief       the CPUs a task may run on
+ * @return      the mask, RTX_ERR if the task is dormant
+ *****************************************************************************/
+int k_tsk_get_affinity(task_t task_id)
+{
+	if (task_id >= MAX_TASKS || g_tcbs[task_id].state == DORMANT) {
+		return RTX_ERR;
+	}
+	return g_tcbs[task_id].affinity;
+}
+
 task_t k_tsk_get_tid(void)
 {
 #ifdef DEBUG_0
@@ -584,16 +898,19 @@ int k_tsk_ls(task_t *buf, int count){
 // Helper functions
 int l_insert (TCB *new_tcb)
 {
-	//printf("DEBUG: new_tcb->prio : %d task_q_head->prio : %d\r\n", new_tcb->prio, task_q_head->prio);
-	if (task_q_head == NULL || new_tcb == NULL || (g_num_active_tasks -1) >= MAX_TASKS){return RTX_ERR;} // Error
-	if (task_q_head->prio > new_tcb->prio) // Schedule higher priority task to run first
+	if (new_tcb == NULL){return RTX_ERR;} // Error
+	K_RQ *p_rq = k_rq_of(new_tcb->cpu);
+	//printf("DEBUG: new_tcb->prio : %d p_rq->head->prio : %d\r\n", new_tcb->prio, p_rq->head->prio);
+	if (p_rq->head == NULL || (g_num_active_tasks -1) >= MAX_TASKS){return RTX_ERR;} // Error
+	if (new_tcb->prio != PRIO_NULL){p_rq->nr++;}
+	if (p_rq->head->prio > new_tcb->prio) // Schedule higher priority task to run first
 	{
-		new_tcb->next = task_q_head;
-		task_q_head = new_tcb;
+		new_tcb->next = p_rq->head;
+		p_rq->head = new_tcb;
 		return RTX_OK;
 	}
-	TCB *curr = task_q_head;
-	TCB *next = task_q_head->next;
+	TCB *curr = p_rq->head;
+	TCB *next = p_rq->head->next;
 	TCB *prev = curr;
 	while (next != NULL && next->prio < new_tcb->prio){prev = curr; curr = next; next = next->next;} // Find spot for new_tcb
 	if (next == NULL)
@@ -641,15 +958,17 @@ int l_insert (TCB *new_tcb)
 }
 TCB *l_pop(TCB *to_rm)
 {
-	TCB *temp = task_q_head;
-	TCB *prev = task_q_head;
+	K_RQ *p_rq = k_rq_of(to_rm->cpu);
+	TCB *temp = p_rq->head;
+	TCB *prev = p_rq->head;
 	while (temp != NULL && temp != to_rm){prev = temp; temp = temp->next;} // Linear search the queue for to_rm
 	if (temp == NULL){return NULL;} // Error
 	//Here: temp == to_rm
-	if (temp == task_q_head)
+	if (temp->prio != PRIO_NULL){p_rq->nr--;}
+	if (temp == p_rq->head)
 	{
 		// Update new head
-		task_q_head = temp->next;
+		p_rq->head = temp->next;
 	}
 	prev->next = temp->next;
 	temp->next = NULL;
@@ -684,11 +1003,64 @@ void l_print(TCB *node)
 }
 TCB *get_qhead(void)
 {
-	return task_q_head;
+	return k_rq_of(k_cpu_id())->head;
 }
 void set_qhead(TCB *new_head)
 {
-	task_q_head = new_head;
+	k_rq_of(k_cpu_id())->head = new_head;
+}
+void wq_insert(TCB **pp_head, TCB *p_tcb)
+{
+	p_tcb->wait_q = pp_head;
+	// Skip tasks of higher or equal priority so the queue stays FIFO within a priority
+	while (*pp_head != NULL && (*pp_head)->prio <= p_tcb->prio){pp_head = &(*pp_head)->wait_next;}
+	p_tcb->wait_next = *pp_head;
+	*pp_head = p_tcb;
+}
+TCB *wq_pop(TCB **pp_head)
+{
+	TCB *temp = *pp_head;
+	if (temp == NULL){return NULL;} // Empty queue
+	*pp_head = temp->wait_next;
+	temp->wait_next = NULL;
+	temp->wait_q = NULL;
+	return temp;
+}
+int wq_remove(TCB **pp_head, TCB *to_rm)
+{
+	while (*pp_head != NULL && *pp_head != to_rm){pp_head = &(*pp_head)->wait_next;}
+	if (*pp_head == NULL){return RTX_ERR;} // Not queued here
+	*pp_head = to_rm->wait_next;
+	to_rm->wait_next = NULL;
+	to_rm->wait_q = NULL;
+	return RTX_OK;
+}
+void k_tsk_reprio(TCB *p_tcb, U8 prio)
+{
+	// Move the task so whichever queue it is on stays priority ordered
+	K_CRIT crit = k_crit_enter();
+	if (p_tcb->prio != prio)
+	{
+		K_RQ *p_rq = k_rq_lock(p_tcb);	// keeps a READY task where it is
+		if (p_tcb->state == READY)
+		{
+			l_update_priority(p_tcb, prio);
+			k_rq_kick(p_tcb);
+		}
+		else if (p_tcb->wait_q != NULL)
+		{
+			TCB **pp_head = p_tcb->wait_q;
+			wq_remove(pp_head, p_tcb);
+			p_tcb->prio = prio;
+			wq_insert(pp_head, p_tcb);
+		}
+		else
+		{
+			p_tcb->prio = prio;
+		}
+		k_rq_unlock(p_rq);
+	}
+	k_crit_exit(crit);
 }
 /*
  *===========================================================================
@@ -51,7 +51,7 @@
  *==========================================================================
  */
 
-extern TCB *gp_current_task;
+// gp_current_task is a macro over the per-CPU g_cur_task, see k_inc.h
 
 /*
  *===========================================================================
@@ -60,6 +60,7 @@ extern TCB *gp_current_task;
  */
 
 extern void task_null       (void);
+extern void task_null_cpu   (void);
 
 
 
@@ -70,9 +71,14 @@ int     k_tsk_init          (RTX_TASK_INFO *task_info, int num_tasks);
 int     k_tsk_create_new    (RTX_TASK_INFO *p_taskinfo, TCB *p_tcb, task_t tid);
                                  /* create a new task with initial context sitting on a dummy stack frame */
 TCB *   scheduler           (void);  /* return the TCB of the next ready to run task */
-void    k_tsk_switch        (TCB *); /* kernel thread context switch, two stacks */
+void    k_tsk_switch        (TCB *, TCB *); /* kernel thread context switch, two stacks */
+void    k_tsk_entry         (void);  /* first code of a new task, see k_tsk_create_new */
+void    k_tsk_start         (void);  /* drops the kernel lock for k_tsk_entry */
 int     k_tsk_run_new       (void);  /* kernel runs a new thread  */
 int     k_tsk_yield         (void);  /* kernel tsk_yield function */
+void    k_tsk_block         (U8 state);     /* block the running task in the given state */
+void    k_tsk_block_on      (U8 state, volatile U32 *p_lock);  /* block, dropping the waker's spinlock */
+void    k_tsk_unblock       (TCB *p_tcb);   /* make a blocked task ready again */
 
 // Not implemented, to be done by students
 
@@ -87,6 +93,9 @@ void    k_tsk_exit          (void);
 int     k_tsk_set_prio      (task_t task_id, U8 prio);
 int     k_tsk_get_info      (task_t task_id, RTX_TASK_INFO *buffer);
 task_t  k_tsk_get_tid       (void);
+int     k_tsk_create_ex     (task_t *task, const RTX_TASK_INFO *info);
+int     k_tsk_set_affinity  (task_t task_id, U8 mask);
+int     k_tsk_get_affinity  (task_t task_id);
 int     k_tsk_create_rt     (task_t *tid, TASK_RT *task);
 void    k_tsk_done_rt       (void);
 void    k_tsk_suspend       (struct timeval_rt *tv);
@@ -98,5 +107,9 @@ int l_update_priority(TCB *, U8);	// Updates priority of TCB in queue
 void l_print(TCB *);				// Prints given node and all subsequent nodes
 TCB *get_qhead(void);				// Returns global head variable
 void set_qhead(TCB *);				// Sets gloabl head variable
+void wq_insert(TCB **, TCB *);		// Inserts TCB into a priority ordered wait queue
+TCB *wq_pop(TCB **);				// Removes the first TCB of a wait queue
+int wq_remove(TCB **, TCB *);		// Removes specified TCB from a wait queue
+void k_tsk_reprio(TCB *, U8);		// Changes the effective priority of a TCB on any queue
 
 #endif // ! K_TASK_H_
@@ -0,0 +1,42 @@
+/**
+ * @file:   k_time.c
+ * @brief:  kernel 64-bit monotonic clock
+ * @date:   2021/03/09
+ *
+ * @note    The clock is the 64 bit global timer, shared by both cores and
+ *          restarted from zero by k_rtx_init. It does not wrap in the
+ *          lifetime of the board, so readers need neither an epoch nor an
+ *          interrupt, and every CPU reads the same time.
+ *          No sequence counter is needed either. There is no software state
+ *          for a writer to tear, only the counter itself, and
+ *          global_timer_get_val rereads its upper word until it did not
+ *          change under the lower one, so each read is a consistent 64 bit
+ *          value, from any CPU and from IRQ context.
+ */
+
+#include "k_time.h"
+#include "timer.h"
+
+/**
+ * @brief   microseconds since k_rtx_init started the global timer
+ */
+U64 k_get_time_us(void)
+{
+    return global_timer_get_val() / GLOBAL_TIMER_TICKS_PER_US;
+}
+
+/**
+ * @brief   get_time syscall, the monotonic clock as seconds and microseconds
+ */
+int k_get_time(TIMEVAL *tv)
+{
+    U64 us;
+
+    if (tv == NULL) {
+        return RTX_ERR;
+    }
+    us = k_get_time_us();
+    tv->sec  = (U32)(us / 1000000U);
+    tv->usec = (U32)(us % 1000000U);
+    return RTX_OK;
+}
@@ -0,0 +1,15 @@
+/**
+ * @file:   k_time.h
+ * @brief:  kernel 64-bit monotonic clock header file
+ * @date:   2021/03/09
+ */
+
+#ifndef K_TIME_H_
+#define K_TIME_H_
+
+#include "k_inc.h"
+
+U64  k_get_time_us(void);
+int  k_get_time(TIMEVAL *tv);
+
+#endif /* ! K_TIME_H_ */
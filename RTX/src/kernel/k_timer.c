@@ -0,0 +1,296 @@
+/**
+ * @file:   k_timer.c
+ * @brief:  kernel software timers
+ * @date:   2021/03/10
+ *
+ * @note    Armed timers hang off a hashed timing wheel with one slot per
+ *          tick, so arming and cancelling are O(1). Each tick of HPS timer0
+ *          only walks the slot for that tick and skips timers due on a later
+ *          lap. An expired timer goes on the fire list, a periodic one is put
+ *          back on the wheel right away so its period does not drift. The IRQ
+ *          worker task then runs the actions outside the IRQ. If an action
+ *          is still queued when its timer fires again, the fires are counted
+ *          and not queued twice. Kernel timeouts (k_timer_start) skip the
+ *          worker and run their callback in the tick itself.
+ *          The tick runs on CPU0 while the syscalls and the worker may run
+ *          on the other core, so all three hold the kernel lock whenever they
+ *          touch the wheel, the fire list or a timer. The syscalls get it
+ *          from k_svc_enter, the tick and the worker take k_crit_enter.
+ */
+
+#include "k_timer.h"
+#include "k_irq.h"
+#include "k_crit.h"
+
+static K_TIMER  g_timers[MAX_TIMERS];
+static K_TIMER *g_wheel[TIMER_WHEEL_SIZE];
+static K_TIMER *gp_fire_head = NULL;
+static K_TIMER *gp_fire_tail = NULL;
+static U32      g_timer_ticks = 0;          // ticks since boot
+static U32      g_timer_run_queued = 0;     // k_timer_run is on the deferred work queue
+
+static void wheel_insert(K_TIMER *p_timer)
+{
+    K_TIMER **pp_slot = &g_wheel[p_timer->expires & (TIMER_WHEEL_SIZE - 1)];
+
+    p_timer->prev = NULL;
+    p_timer->next = *pp_slot;
+    if (*pp_slot != NULL) {
+        (*pp_slot)->prev = p_timer;
+    }
+    *pp_slot = p_timer;
+}
+
+static void wheel_remove(K_TIMER *p_timer)
+{
+    if (p_timer->prev != NULL) {
+        p_timer->prev->next = p_timer->next;
+    } else {
+        g_wheel[p_timer->expires & (TIMER_WHEEL_SIZE - 1)] = p_timer->next;
+    }
+    if (p_timer->next != NULL) {
+        p_timer->next->prev = p_timer->prev;
+    }
+    p_timer->next = NULL;
+    p_timer->prev = NULL;
+}
+
+/**
+ * @brief   run the actions of expired timers, deferred from k_timer_tick
+ * @note    runs in the IRQ worker task
+ */
+static void k_timer_run(void *arg)
+{
+    while (1) {
+        K_TIMER *p_timer;
+        RTX_TIMER_ACTION action;
+        RTX_TIMER_EVENT event;
+        K_CRIT crit = k_crit_enter();
+
+        p_timer = gp_fire_head;
+        if (p_timer == NULL) {
+            g_timer_run_queued = 0;
+            k_crit_exit(crit);
+            return;
+        }
+        gp_fire_head = p_timer->fire_next;
+        if (gp_fire_head == NULL) {
+            gp_fire_tail = NULL;
+        }
+        p_timer->fire_next = NULL;
+        p_timer->queued = 0;
+
+        if (p_timer->state == TIMER_DEAD) {
+            p_timer->state = TIMER_FREE;
+            k_crit_exit(crit);
+            continue;
+        }
+        action = p_timer->action;
+        event.timer = p_timer - g_timers;
+        event.expiries = p_timer->expiries;
+        p_timer->expiries = 0;
+
+        if (action.type == TIMER_TOPIC) {
+            k_topic_publish(action.topic, &event, sizeof(event));
+            k_crit_exit(crit);
+        } else {
+            k_crit_exit(crit);
+            action.fn(action.arg);
+        }
+    }
+}
+
+/**
+ * @brief   advance the wheel by one tick, called from the HPS timer0 IRQ
+ * @note    kernel timeout callbacks run with the kernel lock held
+ * @return  TRUE if a kernel timeout woke a task that outranks the current one
+ */
+int k_timer_tick(void)
+{
+    K_TIMER *p_timer;
+    K_TIMER *p_next;
+    K_CRIT crit = k_crit_enter();
+    U32 now = ++g_timer_ticks;
+    int resched = FALSE;
+
+    for (p_timer = g_wheel[now & (TIMER_WHEEL_SIZE - 1)]; p_timer != NULL; p_timer = p_next) {
+        p_next = p_timer->next;
+        if (p_timer->expires != now) {
+            continue;                       // due on a later lap of the wheel
+        }
+
+        wheel_remove(p_timer);
+        if (p_timer->action.type == TIMER_IRQ_CALLBACK) {
+            p_timer->state = TIMER_FREE;
+            if (p_timer->irq_fn(p_timer->action.arg)) {
+                resched = TRUE;
+            }
+            continue;
+        }
+        p_timer->expiries++;
+        if (!p_timer->queued) {
+            p_timer->queued = 1;
+            if (gp_fire_tail == NULL) {
+                gp_fire_head = p_timer;
+            } else {
+                gp_fire_tail->fire_next = p_timer;
+            }
+            gp_fire_tail = p_timer;
+        }
+
+        if (p_timer->period != 0) {
+            p_timer->expires = now + p_timer->period;
+            wheel_insert(p_timer);
+        } else {
+            p_timer->state = TIMER_IDLE;
+        }
+    }
+
+    // retried on the next tick if the deferred work queue was full
+    if (gp_fire_head != NULL && !g_timer_run_queued) {
+        if (k_irq_defer(k_timer_run, NULL) == RTX_OK) {
+            g_timer_run_queued = 1;
+        }
+    }
+    k_crit_exit(crit);
+    return resched;
+}
+
+static K_TIMER *timer_alloc(void)
+{
+    for (int i = 0; i < MAX_TIMERS; i++) {
+        if (g_timers[i].state == TIMER_FREE) {
+            return &g_timers[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief   allocate a timer and arm it to fire period_us from now
+ * @return  timer id on success, RTX_ERR on failure
+ */
+int k_timer_create(U32 period_us, int mode, const RTX_TIMER_ACTION *action)
+{
+    K_TIMER *p_timer;
+    U32 ticks;
+
+    if (action == NULL || period_us == 0 || (mode != TIMER_ONESHOT && mode != TIMER_PERIODIC)) {
+        return RTX_ERR;
+    }
+    if (action->type == TIMER_CALLBACK) {
+        // the callback runs privileged in the IRQ worker
+        if (action->fn == NULL || (gp_current_task != NULL && gp_current_task->priv == 0)) {
+            return RTX_ERR;
+        }
+    } else if (action->type != TIMER_TOPIC || action->topic < 0 || action->topic >= MAX_TOPICS) {
+        return RTX_ERR;
+    }
+
+    p_timer = timer_alloc();
+    if (p_timer == NULL) {
+        return RTX_ERR;
+    }
+
+    ticks = (period_us + TIMER_TICK_US - 1) / TIMER_TICK_US;
+    p_timer->fire_next = NULL;
+    p_timer->expires   = g_timer_ticks + ticks;
+    p_timer->period    = (mode == TIMER_PERIODIC) ? ticks : 0;
+    p_timer->expiries  = 0;
+    p_timer->queued    = 0;
+    p_timer->owner     = (gp_current_task == NULL) ? TID_NULL : gp_current_task->tid;
+    p_timer->action    = *action;
+    p_timer->state     = TIMER_ARMED;
+    wheel_insert(p_timer);
+
+    return p_timer - g_timers;
+}
+
+/**
+ * @brief   kernel timeout, fn(arg) runs in the tick IRQ once us have passed
+ * @return  timer id on success, RTX_ERR if the pool is empty
+ * @note    fn sees the timer already freed and runs with the kernel lock held
+ */
+int k_timer_start(U32 us, int (*fn)(void *arg), void *arg)
+{
+    K_CRIT crit = k_crit_enter();
+    K_TIMER *p_timer = timer_alloc();
+    U32 ticks = (us + TIMER_TICK_US - 1) / TIMER_TICK_US;
+
+    if (p_timer != NULL) {
+        p_timer->fire_next   = NULL;
+        p_timer->expires     = g_timer_ticks + (ticks == 0 ? 1 : ticks);
+        p_timer->period      = 0;
+        p_timer->expiries    = 0;
+        p_timer->queued      = 0;
+        p_timer->owner       = TID_NULL;
+        p_timer->action.type = TIMER_IRQ_CALLBACK;
+        p_timer->action.fn   = NULL;
+        p_timer->irq_fn      = fn;
+        p_timer->action.arg  = arg;
+        p_timer->state       = TIMER_ARMED;
+        wheel_insert(p_timer);
+    }
+    k_crit_exit(crit);
+    return (p_timer == NULL) ? RTX_ERR : p_timer - g_timers;
+}
+
+static void timer_free(K_TIMER *p_timer)
+{
+    if (p_timer->state == TIMER_ARMED) {
+        wheel_remove(p_timer);
+    }
+    // the worker frees it once it takes it off the fire list
+    p_timer->state = p_timer->queued ? TIMER_DEAD : TIMER_FREE;
+}
+
+/**
+ * @brief   disarm and free a timer
+ * @return  RTX_OK on success, RTX_ERR if the timer is not in use or
+ *          belongs to another task and the caller is not privileged
+ */
+int k_timer_delete(int timer)
+{
+    K_TIMER *p_timer;
+
+    if (timer < 0 || timer >= MAX_TIMERS) {
+        return RTX_ERR;
+    }
+    p_timer = &g_timers[timer];
+    if (p_timer->state == TIMER_FREE || p_timer->state == TIMER_DEAD) {
+        return RTX_ERR;
+    }
+    if (p_timer->owner != gp_current_task->tid && gp_current_task->priv == 0) {
+        return RTX_ERR;
+    }
+    timer_free(p_timer);
+    return RTX_OK;
+}
+
+/**
+ * @brief   cancel a kernel timeout that has not fired yet
+ */
+void k_timer_cancel(int timer)
+{
+    K_CRIT crit = k_crit_enter();
+
+    if (timer >= 0 && timer < MAX_TIMERS && g_timers[timer].state == TIMER_ARMED) {
+        timer_free(&g_timers[timer]);
+    }
+    k_crit_exit(crit);
+}
+
+/**
+ * @brief   free the timers of an exiting task
+ */
+void k_timer_exit(TCB *p_tcb)
+{
+    for (int i = 0; i < MAX_TIMERS; i++) {
+        K_TIMER *p_timer = &g_timers[i];
+
+        if (p_timer->owner == p_tcb->tid &&
+            (p_timer->state == TIMER_ARMED || p_timer->state == TIMER_IDLE)) {
+            timer_free(p_timer);
+        }
+    }
+}
@@ -0,0 +1,48 @@
+/**
+ * @file:   k_timer.h
+ * @brief:  kernel software timers header file
+ * @date:   2021/03/10
+ */
+
+#ifndef K_TIMER_H_
+#define K_TIMER_H_
+
+#include "k_rtx.h"
+#include "common_ext.h"
+
+#define MAX_TIMERS          1024    /* software timers in the system */
+#define TIMER_WHEEL_SIZE    256     /* wheel slots, one tick each, power of 2 */
+#define TIMER_TICK_US       MIN_RTX_QTM
+
+#define TIMER_IRQ_CALLBACK  2       /* kernel only: one-shot, fn(arg) runs in the tick IRQ and returns TRUE to reschedule */
+
+/* Timer States */
+#define TIMER_FREE          0       /* in the pool */
+#define TIMER_ARMED         1       /* on the wheel */
+#define TIMER_IDLE          2       /* one-shot that has fired */
+#define TIMER_DEAD          3       /* deleted while its action was queued */
+
+/**
+ * @brief one software timer, on a wheel slot list while armed and on the
+ *        fire list while its action waits for the IRQ worker
+ */
+typedef struct k_timer {
+    struct k_timer     *next;       /* wheel slot list */
+    struct k_timer     *prev;
+    struct k_timer     *fire_next;  /* fire list */
+    U32                 expires;    /* tick it fires at */
+    U32                 period;     /* ticks between fires, 0 for one-shot */
+    U32                 expiries;   /* fires not handed to the action yet */
+    U8                  state;
+    U8                  queued;     /* on the fire list */
+    task_t              owner;
+    RTX_TIMER_ACTION    action;
+    int                (*irq_fn)(void *arg);    /* TIMER_IRQ_CALLBACK, returns a reschedule request */
+} K_TIMER;
+
+int  k_timer_tick(void);
+int  k_timer_start(U32 us, int (*fn)(void *arg), void *arg);
+void k_timer_cancel(int timer);
+void k_timer_exit(TCB *p_tcb);
+
+#endif /* ! K_TIMER_H_ */
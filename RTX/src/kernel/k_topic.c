@@ -0,0 +1,292 @@
+/**
+ * @file:   k_topic.c
+ * @brief:  kernel publish/subscribe topics
+ * @date:   2021/03/02
+ *
+ * @note    A published sample is copied once into a reference-counted buffer
+ *          on the kernel heap. Each subscriber's queue only receives a pointer
+ *          to it, and the buffer is freed when the last subscriber releases it.
+ *          A subscriber slot remembers the samples its task received, so
+ *          only a holder can release a sample, and only once, and the
+ *          samples a task still holds are released when it unsubscribes
+ *          or exits.
+ */
+
+#include "k_topic.h"
+
+#ifdef DEBUG_0
+#include "printf.h"
+#endif /* ! DEBUG_0 */
+
+static TOPIC g_topics[MAX_TOPICS];
+
+static int topic_name_eq(const char *a, const char *b)
+{
+    for (int i = 0; i < TOPIC_NAME_LEN; i++) {
+        if (a[i] != b[i]) {
+            return FALSE;
+        }
+        if (a[i] == '\0') {
+            break;
+        }
+    }
+    return TRUE;
+}
+
+static TOPIC_SUB *topic_find_sub(TOPIC *p_topic, task_t tid)
+{
+    for (int i = 0; i < MAX_TOPIC_SUBS; i++) {
+        if (p_topic->subs[i].tid == tid) {
+            return &p_topic->subs[i];
+        }
+    }
+    return NULL;
+}
+
+static TOPIC *topic_get(int topic)
+{
+    if (topic < 0 || topic >= MAX_TOPICS || g_topics[topic].in_use == FALSE) {
+        return NULL;
+    }
+    return &g_topics[topic];
+}
+
+/* drop one reference, the last one frees the sample */
+static void topic_put(TOPIC_BUF *p_buf)
+{
+    if (--p_buf->refcnt == 0) {
+        k_mem_dealloc(p_buf);
+    }
+}
+
+/* release everything queued for or held by a subscriber and free its slot */
+static void topic_drop_sub(TOPIC *p_topic, TOPIC_SUB *p_sub)
+{
+    while (p_sub->head != p_sub->tail) {
+        topic_put(p_sub->q[p_sub->head % TOPIC_Q_LEN]);
+        p_sub->head++;
+    }
+    while (p_sub->num_held > 0) {
+        topic_put(p_sub->held[--p_sub->num_held]);
+    }
+    p_sub->tid = TID_NULL;
+    p_sub->head = p_sub->tail = 0;
+    p_sub->dropped = 0;
+    p_topic->num_subs--;
+}
+
+/**
+ * @brief   look up a topic by name, creating it if it does not exist yet
+ * @return  topic id on success, RTX_ERR if the name is invalid or no topic is free
+ */
+int k_topic_open(const char *name) {
+#ifdef DEBUG_0
+    printf("k_topic_open: name = 0x%x\r\n", name);
+#endif /* DEBUG_0 */
+    int free_id = RTX_ERR;
+
+    if (name == NULL || name[0] == '\0') {
+        return RTX_ERR;
+    }
+
+    for (int i = 0; i < MAX_TOPICS; i++) {
+        if (g_topics[i].in_use == FALSE) {
+            if (free_id == RTX_ERR) {
+                free_id = i;
+            }
+        } else if (topic_name_eq(g_topics[i].name, name)) {
+            return i;
+        }
+    }
+
+    if (free_id != RTX_ERR) {
+        TOPIC *p_topic = &g_topics[free_id];
+        int i = 0;
+        for (; i < TOPIC_NAME_LEN && name[i] != '\0'; i++) {
+            p_topic->name[i] = name[i];
+        }
+        for (; i < TOPIC_NAME_LEN; i++) {
+            p_topic->name[i] = '\0';
+        }
+        p_topic->num_subs = 0;
+        p_topic->in_use = TRUE;
+    }
+    return free_id;
+}
+
+int k_topic_subscribe(int topic) {
+    TOPIC *p_topic = topic_get(topic);
+    TOPIC_SUB *p_sub;
+
+    if (p_topic == NULL || topic_find_sub(p_topic, gp_current_task->tid) != NULL) {
+        return RTX_ERR;
+    }
+
+    p_sub = topic_find_sub(p_topic, TID_NULL);
+    if (p_sub == NULL) {
+        return RTX_ERR;     // no free subscriber slot
+    }
+
+    p_sub->tid = gp_current_task->tid;
+    p_sub->head = p_sub->tail = 0;
+    p_sub->dropped = 0;
+    p_sub->num_held = 0;
+    p_topic->num_subs++;
+    return RTX_OK;
+}
+
+/**
+ * @brief   stop receiving samples of a topic
+ * @note    samples received from the topic and not released yet are
+ *          released, the caller must not touch them afterwards
+ */
+int k_topic_unsubscribe(int topic) {
+    TOPIC *p_topic = topic_get(topic);
+    TOPIC_SUB *p_sub;
+
+    if (p_topic == NULL || (p_sub = topic_find_sub(p_topic, gp_current_task->tid)) == NULL) {
+        return RTX_ERR;
+    }
+
+    topic_drop_sub(p_topic, p_sub);
+    return RTX_OK;
+}
+
+/**
+ * @brief   publish one sample to every subscriber of a topic
+ * @return  number of subscribers the sample was queued to, RTX_ERR on failure
+ * @note    a subscriber whose queue is full misses the sample
+ */
+int k_topic_publish(int topic, const void *buf, size_t len) {
+#ifdef DEBUG_0
+    printf("k_topic_publish: topic = %d, buf=0x%x, len=%d\r\n", topic, buf, len);
+#endif /* DEBUG_0 */
+    TOPIC *p_topic = topic_get(topic);
+    TOPIC_BUF *p_buf;
+    U32 delivered = 0;
+    int preempt = FALSE;
+
+    if (p_topic == NULL || buf == NULL || len == 0) {
+        return RTX_ERR;
+    }
+    if (p_topic->num_subs == 0) {
+        return 0;
+    }
+
+    p_buf = k_mem_alloc_os(sizeof(TOPIC_BUF) + len);
+    if (p_buf == NULL) {
+        return RTX_ERR;
+    }
+    p_buf->length = len;
+    p_buf->topic = (U8)topic;
+    p_buf->publisher = gp_current_task->tid;
+    for (size_t i = 0; i < len; i++) {
+        ((U8 *)(p_buf + 1))[i] = ((const U8 *)buf)[i];
+    }
+
+    for (int i = 0; i < MAX_TOPIC_SUBS; i++) {
+        TOPIC_SUB *p_sub = &p_topic->subs[i];
+        if (p_sub->tid == TID_NULL) {
+            continue;
+        }
+        if ((U8)(p_sub->tail - p_sub->head) >= TOPIC_Q_LEN) {
+            p_sub->dropped++;
+            continue;
+        }
+        p_sub->q[p_sub->tail % TOPIC_Q_LEN] = p_buf;
+        p_sub->tail++;
+        delivered++;
+
+        TCB *p_tcb = &g_tcbs[p_sub->tid];
+        if (p_tcb->state == BLK_TOPIC) {
+            k_tsk_unblock(p_tcb);
+            preempt = TRUE;
+        }
+    }
+
+    p_buf->refcnt = delivered;
+    if (delivered == 0) {
+        k_mem_dealloc(p_buf);
+    }
+
+    if (preempt && check_prio() != RTX_OK) {
+        k_tsk_run_new();
+    }
+    return delivered;
+}
+
+/**
+ * @brief   wait for the next sample of a subscribed topic
+ * @return  read-only pointer to the shared sample, NULL on failure or
+ *          when the caller already holds TOPIC_MAX_HELD samples of the topic
+ * @param   len     if not NULL, receives the sample length in bytes
+ */
+const void *k_topic_recv(int topic, size_t *len) {
+    TOPIC *p_topic = topic_get(topic);
+    TOPIC_SUB *p_sub;
+    TOPIC_BUF *p_buf;
+
+    if (p_topic == NULL || (p_sub = topic_find_sub(p_topic, gp_current_task->tid)) == NULL ||
+        p_sub->num_held == TOPIC_MAX_HELD) {
+        return NULL;
+    }
+
+    // woken by a publish on any of our topics, so check again
+    while (p_sub->head == p_sub->tail) {
+        k_tsk_block(BLK_TOPIC);
+    }
+
+    p_buf = p_sub->q[p_sub->head % TOPIC_Q_LEN];
+    p_sub->head++;
+    p_sub->held[p_sub->num_held++] = p_buf;
+
+    if (len != NULL) {
+        *len = p_buf->length;
+    }
+    return p_buf + 1;
+}
+
+/**
+ * @brief   hand back a sample obtained from topic_recv
+ * @return  RTX_OK on success, RTX_ERR if the caller does not hold sample
+ * @note    sample is only compared against the caller's held samples, it
+ *          is not dereferenced before it is found there
+ */
+int k_topic_release(const void *sample) {
+    TOPIC_BUF *p_buf;
+
+    if (sample == NULL) {
+        return RTX_ERR;
+    }
+    p_buf = ((TOPIC_BUF *)sample) - 1;
+
+    for (int i = 0; i < MAX_TOPICS; i++) {
+        TOPIC_SUB *p_sub;
+
+        if (g_topics[i].in_use == FALSE ||
+            (p_sub = topic_find_sub(&g_topics[i], gp_current_task->tid)) == NULL) {
+            continue;
+        }
+        for (int j = 0; j < p_sub->num_held; j++) {
+            if (p_sub->held[j] == p_buf) {
+                p_sub->held[j] = p_sub->held[--p_sub->num_held];
+                topic_put(p_buf);
+                return RTX_OK;
+            }
+        }
+    }
+    return RTX_ERR;
+}
+
+/**
+ * @brief   unsubscribe an exiting task from every topic, releasing the
+ *          samples it still holds
+ */
+void k_topic_exit(TCB *p_tcb) {
+    for (int i = 0; i < MAX_TOPICS; i++) {
+        TOPIC_SUB *p_sub;
+        if (g_topics[i].in_use && (p_sub = topic_find_sub(&g_topics[i], p_tcb->tid)) != NULL) {
+            topic_drop_sub(&g_topics[i], p_sub);
+        }
+    }
+}
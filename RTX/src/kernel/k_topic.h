@@ -0,0 +1,57 @@
+/**
+ * @file:   k_topic.h
+ * @brief:  kernel publish/subscribe topics header file
+ * @date:   2021/03/02
+ */
+
+#ifndef K_TOPIC_H_
+#define K_TOPIC_H_
+
+#include "k_rtx.h"
+#include "common_ext.h"
+
+#define MAX_TOPICS          16      /* number of topics in the system */
+#define MAX_TOPIC_SUBS      8       /* subscribers per topic */
+#define TOPIC_Q_LEN         8       /* samples queued per subscriber, power of 2 */
+#define TOPIC_MAX_HELD      8       /* samples a subscriber may hold before it releases one */
+
+/**
+ * @brief header in front of every published sample on the kernel heap
+ */
+typedef struct topic_buf {
+    U32         refcnt;             /* subscribers still holding the sample */
+    size_t      length;             /* sample length in bytes, header excluded */
+    U8          topic;              /* topic the sample was published on */
+    task_t      publisher;          /* tid of the publisher */
+    U16         reserved;
+} __attribute__((aligned(8))) TOPIC_BUF;
+
+/**
+ * @brief one subscriber's queue of sample descriptors
+ */
+typedef struct topic_sub {
+    task_t      tid;                /* subscriber, TID_NULL if the slot is free */
+    U8          head;               /* next descriptor to receive */
+    U8          tail;               /* next free descriptor */
+    U8          dropped;            /* samples dropped because the queue was full */
+    U8          num_held;           /* entries of held in use */
+    TOPIC_BUF  *q[TOPIC_Q_LEN];
+    TOPIC_BUF  *held[TOPIC_MAX_HELD];   /* received and not released yet */
+} TOPIC_SUB;
+
+typedef struct topic {
+    char        name[TOPIC_NAME_LEN];
+    U8          in_use;
+    U8          num_subs;
+    TOPIC_SUB   subs[MAX_TOPIC_SUBS];
+} TOPIC;
+
+int k_topic_open(const char *name);
+int k_topic_subscribe(int topic);
+int k_topic_unsubscribe(int topic);
+int k_topic_publish(int topic, const void *buf, size_t len);
+const void *k_topic_recv(int topic, size_t *len);
+int k_topic_release(const void *sample);
+void k_topic_exit(TCB *p_tcb);
+
+#endif /* ! K_TOPIC_H_ */
@@ -0,0 +1,183 @@
+/**
+ * @file:   k_trace.c
+ * @brief:  kernel event trace
+ * @date:   2021/03/19
+ *
+ * @note    Context switches, wakeups, interrupts, message passing and heap
+ *          calls are recorded as 16 byte records in a per-CPU ring. Like
+ *          k_log, a writer reserves its slot with LDREX/STREX and never
+ *          masks IRQs, and the oldest records are overwritten when a ring
+ *          fills up. Records are stamped with the PMU cycle counter of
+ *          their CPU. TRACE_START has every CPU sample its counter at
+ *          almost the same time, which lets the host tool line the CPUs
+ *          up on one timeline.
+ *          TRACE_DUMP prints the rings on the JTAG UART. A memory dump of
+ *          g_ktrace is decoded by tools/trace2json.py just the same.
+ *          The cost of one event is measured at boot by timing
+ *          KTRACE_CAL_EVENTS calls with the cycle counter and is printed
+ *          at the top of every dump, loop overhead included. It only
+ *          covers the record itself. A trace point that is compiled in
+ *          also costs a load and a branch while tracing is stopped.
+ */
+
+#include "k_trace.h"
+#include "k_ipi.h"
+#include "k_smp.h"
+#include "k_time.h"
+#include "k_crit.h"
+#include "printf.h"
+
+KTRACE_BUF g_ktrace;
+
+static volatile U32 g_ktrace_on = FALSE;
+
+/**
+ * @brief   sample this CPU's cycle counter for TRACE_START
+ */
+static void trace_sync(void *arg)
+{
+    g_ktrace.sync[k_cpu_id()] = __get_PMCCNTR();
+}
+
+/**
+ * @brief   fill in the dump header, then measure the cycle counter rate
+ *          and the cost of one event
+ * @pre     the global timer and the cycle counter are running, called on CPU 0
+ *          before the other cores are up
+ */
+void k_trace_init(void)
+{
+    K_CRIT crit = k_irq_save();
+    U64 start_us;
+    U32 start;
+
+    g_ktrace.magic    = KTRACE_MAGIC;
+    g_ktrace.num_cpus = NUM_CPUS;
+    g_ktrace.buf_size = KTRACE_BUF_SIZE;
+
+    start_us = k_get_time_us();
+    start    = __get_PMCCNTR();
+    while (k_get_time_us() - start_us < KTRACE_CAL_US) {
+        ;
+    }
+    g_ktrace.cycles_per_us = (__get_PMCCNTR() - start) / KTRACE_CAL_US;
+
+    g_ktrace_on = TRUE;
+    start = __get_PMCCNTR();
+    for (U32 i = 0; i < KTRACE_CAL_EVENTS; i++) {
+        k_trace(KTRACE_NONE, 0, 0, 0);  // NONE records are skipped by the dump
+    }
+    g_ktrace.event_cycles = (__get_PMCCNTR() - start) / KTRACE_CAL_EVENTS;
+    g_ktrace_on = FALSE;
+    g_ktrace.ring[k_cpu_id()].head = 0;
+
+    k_irq_restore(crit);
+}
+
+/**
+ * @brief   record one event on the calling CPU's ring
+ * @note    safe from IRQ handlers, does not mask interrupts, does nothing
+ *          while tracing is stopped
+ */
+void k_trace(U32 event, U32 arg, U32 a0, U32 a1)
+{
+    KTRACE_RING *p_ring;
+    KTRACE_REC *p_rec;
+    U32 idx;
+
+    if (!g_ktrace_on) {
+        return;
+    }
+    p_ring = &g_ktrace.ring[k_cpu_id()];
+    do {
+        idx = __ldrex(&p_ring->head);
+    } while (__strex(idx + 1, &p_ring->head));
+
+    p_rec = &p_ring->rec[idx & (KTRACE_BUF_SIZE - 1)];
+    p_rec->event = KTRACE_NONE;             // slot is being rewritten
+    p_rec->time  = __get_PMCCNTR();
+    p_rec->tid   = (gp_current_task == NULL) ? TID_NULL : gp_current_task->tid;
+    p_rec->arg   = (U16)arg;
+    p_rec->a0    = a0;
+    p_rec->a1    = a1;
+    __dmb(0xF);                             // record is complete before it is marked so
+    p_rec->event = (U8)event;
+}
+
+/**
+ * @brief   print the rings of every CPU, oldest record first
+ * @pre     tracing is stopped
+ */
+static void trace_dump(void)
+{
+    printf("ktrace: begin cpus %u size %u cycles_per_us %u event_cycles %u sync_cpu %u\r\n",
+           g_ktrace.num_cpus, g_ktrace.buf_size, g_ktrace.cycles_per_us,
+           g_ktrace.event_cycles, g_ktrace.sync_cpu);
+    for (U32 cpu = 0; cpu < NUM_CPUS; cpu++) {
+        printf("ktrace: sync %u %u\r\n", cpu, g_ktrace.sync[cpu]);
+    }
+    for (U32 cpu = 0; cpu < NUM_CPUS; cpu++) {
+        KTRACE_RING *p_ring = &g_ktrace.ring[cpu];
+        U32 head = p_ring->head;
+        U32 idx = 0;
+
+        if (head > KTRACE_BUF_SIZE) {
+            idx = head - KTRACE_BUF_SIZE;
+            printf("ktrace: lost %u %u\r\n", cpu, idx);
+        }
+        for (; idx != head; idx++) {
+            KTRACE_REC *p_rec = &p_ring->rec[idx & (KTRACE_BUF_SIZE - 1)];
+
+            if (p_rec->event != KTRACE_NONE) {
+                printf("ktrace: %u %x %u %u %u %x %x\r\n", cpu, p_rec->time, p_rec->event,
+                       p_rec->tid, p_rec->arg, p_rec->a0, p_rec->a1);
+            }
+        }
+    }
+    printf("ktrace: end\r\n");
+}
+
+/**
+ * @brief   trace_ctl syscall
+ * @param   cmd TRACE_START, TRACE_STOP or TRACE_DUMP
+ * @return  RTX_OK on success, RTX_ERR for an unknown command or a kernel
+ *          built without KTRACE
+ * @note    entered without the kernel lock, TRACE_START waits for the
+ *          other CPUs to sample their cycle counters
+ */
+int k_trace_ctl(int cmd)
+{
+#ifdef KTRACE
+    U32 self = k_cpu_id();
+
+    switch (cmd) {
+    case TRACE_START:
+        g_ktrace_on = FALSE;
+        for (U32 cpu = 0; cpu < NUM_CPUS; cpu++) {
+            g_ktrace.ring[cpu].head = 0;
+            g_ktrace.sync[cpu] = 0;
+        }
+        g_ktrace.sync_cpu = self;
+        trace_sync(NULL);
+        for (U32 cpu = 0; cpu < NUM_CPUS; cpu++) {
+            if (cpu != self) {
+                k_ipi_call(cpu, trace_sync, NULL, TRUE);
+            }
+        }
+        __dmb(0xF);
+        g_ktrace_on = TRUE;
+        return RTX_OK;
+    case TRACE_STOP:
+        g_ktrace_on = FALSE;
+        return RTX_OK;
+    case TRACE_DUMP:
+        g_ktrace_on = FALSE;
+        trace_dump();
+        return RTX_OK;
+    default:
+        return RTX_ERR;
+    }
+#else
+    return RTX_ERR;
+#endif
+}
@@ -0,0 +1,82 @@
+/**
+ * @file:   k_trace.h
+ * @brief:  kernel event trace header file
+ * @date:   2021/03/19
+ */
+
+#ifndef K_TRACE_H_
+#define K_TRACE_H_
+
+#include "k_inc.h"
+#include "common_ext.h"
+
+#define KTRACE_BUF_SIZE     1024        /* records per CPU, power of 2 */
+#define KTRACE_MAGIC        0x4B545243  /* "KTRC", first word of a memory dump */
+#define KTRACE_CAL_EVENTS   64          /* events timed by k_trace_init */
+#define KTRACE_CAL_US       1000        /* length of the cycle counter calibration */
+
+/*
+ * Event ids, tools/trace2json.py decodes them by number, so only append.
+ * tid is the task running when the event was recorded.
+ */
+#define KTRACE_NONE         0           /* slot being written */
+#define KTRACE_SWITCH       1           /* tid switched to, arg: task switched from, a0: its state */
+#define KTRACE_STATE        2           /* arg: task, a0: its new state */
+#define KTRACE_IRQ_ENTER    3           /* arg: interrupt ID */
+#define KTRACE_IRQ_EXIT     4           /* arg: interrupt ID, a0: reschedule asked */
+#define KTRACE_MSG_SEND     5           /* arg: server, a0: request length */
+#define KTRACE_MSG_RECV     6           /* arg: client, a0: bytes received */
+#define KTRACE_MSG_REPLY    7           /* arg: client, a0: reply bytes copied */
+#define KTRACE_MEM_ALLOC    8           /* a0: size asked for, a1: block or NULL */
+#define KTRACE_MEM_FREE     9           /* a0: block, a1: RTX_OK or RTX_ERR */
+
+/**
+ * @brief one trace record, event is written last so a reader can skip a
+ *        record that is still being written
+ */
+typedef struct ktrace_rec {
+    U32             time;               /* PMU cycle count of the CPU that recorded it */
+    volatile U8     event;              /* KTRACE_* */
+    task_t          tid;
+    U16             arg;
+    U32             a0;
+    U32             a1;
+} KTRACE_REC;
+
+typedef struct ktrace_ring {
+    volatile U32    head;               /* next index to reserve, bumped with LDREX/STREX */
+    KTRACE_REC      rec[KTRACE_BUF_SIZE];
+} KTRACE_RING;
+
+/**
+ * @brief everything a memory dump of g_ktrace needs to be decoded
+ */
+typedef struct ktrace_buf {
+    U32             magic;              /* KTRACE_MAGIC */
+    U32             num_cpus;
+    U32             buf_size;           /* KTRACE_BUF_SIZE */
+    U32             cycles_per_us;      /* cycle counter rate, measured by k_trace_init */
+    U32             event_cycles;       /* cost of one k_trace call, measured by k_trace_init */
+    U32             sync_cpu;           /* CPU that started the trace */
+    U32             sync[NUM_CPUS];     /* cycle count of each CPU at the start */
+    KTRACE_RING     ring[NUM_CPUS];
+} KTRACE_BUF;
+
+extern KTRACE_BUF g_ktrace;
+
+void k_trace_init(void);
+void k_trace(U32 event, U32 arg, U32 a0, U32 a1);
+int  k_trace_ctl(int cmd);
+
+/* build with KTRACE to compile the trace points in */
+#ifdef KTRACE
+#define KTRACE0(ev, arg)            k_trace((ev), (U32)(arg), 0, 0)
+#define KTRACE1(ev, arg, a0)        k_trace((ev), (U32)(arg), (U32)(a0), 0)
+#define KTRACE2(ev, arg, a0, a1)    k_trace((ev), (U32)(arg), (U32)(a0), (U32)(a1))
+#else
+#define KTRACE0(ev, arg)
+#define KTRACE1(ev, arg, a0)
+#define KTRACE2(ev, arg, a0, a1)
+#endif
+
+#endif /* ! K_TRACE_H_ */
@@ -0,0 +1,131 @@
+/**
+ * @file:   k_uart.c
+ * @brief:  kernel UART0 buffering
+ * @date:   2021/03/04
+ *
+ * @note    The RX IRQ is the only producer and the task in uart_rx_recv (KCD)
+ *          is the only consumer of the RX ring. Each side owns one index, so
+ *          neither side needs a critical section for the ring; the barrier
+ *          orders the data before the index that publishes it.
+ *          The wakeup does need one, the consumer may block on the other core
+ *          while the IRQ runs on CPU0. The consumer checks the ring and blocks
+ *          under the kernel lock, which its trap takes, and the IRQ looks for
+ *          the waiter under it too, so the IRQ either publishes the index
+ *          before the check or finds the consumer blocked.
+ *          Transmit goes through the UART0 TX ring in the board driver,
+ *          which the THR empty interrupt drains in FIFO sized bursts.
+ */
+
+#include "k_uart.h"
+#include "Serial.h"
+#include "k_log.h"
+#include "k_crit.h"
+
+static char         g_rx_buf[UART_RX_BUF_SIZE];
+static volatile U32 g_rx_head = 0;          // next slot to fill, written by the IRQ only
+static volatile U32 g_rx_tail = 0;          // next slot to drain, written by the consumer only
+static U32          g_rx_overruns = 0;      // characters dropped because the ring was full
+static TCB         *gp_rx_waiter = NULL;    // consumer blocked in uart_rx_recv
+
+/**
+ * @brief   UART0 receive top half, drains the hardware FIFO into the RX ring
+ * @return  TRUE if a task blocked in uart_rx_recv was made ready
+ */
+int k_uart_rx_irq(void)
+{
+    U32 head = g_rx_head;
+    U32 tail = g_rx_tail;
+    TCB *p_tcb;
+    K_CRIT crit;
+    int woken = FALSE;
+
+    while (UART0_GetRxDataStatus()) {
+        char c = UART0_GetRxData();     // would also clear the interrupt if last character is read
+        if (head - tail < UART_RX_BUF_SIZE) {
+            g_rx_buf[head & (UART_RX_BUF_SIZE - 1)] = c;
+            head++;
+        } else {
+            g_rx_overruns++;
+        }
+    }
+    __dmb(0xF);                         // characters are visible before the index moves
+    g_rx_head = head;
+
+    crit = k_crit_enter();
+    p_tcb = gp_rx_waiter;
+    if (p_tcb != NULL && p_tcb->state == BLK_UART) {
+        gp_rx_waiter = NULL;
+        k_tsk_unblock(p_tcb);
+        woken = TRUE;
+    }
+    k_crit_exit(crit);
+    return woken;
+}
+
+/**
+ * @brief   UART0 interrupt handler, registered with the IRQ dispatcher
+ * @return  TRUE if a woken task outranks the current one
+ */
+int k_uart_irq(U32 irq_id, void *arg)
+{
+    int irq_type = UART0_GetIRQType();      // read once, reading it clears a THR empty interrupt
+
+    if (irq_type == UART0_IIR_RX_DATA || irq_type == UART0_IIR_RX_TIMEOUT) {
+        // queue the characters for the KCD task, only switch if it outranks the current task
+        return k_uart_rx_irq() && check_prio() != RTX_OK;
+    }
+    if (irq_type == UART0_IIR_TX_EMPTY) {
+        UART0_TxIRQ();                      // send the next burst of the TX ring
+    } else if (irq_type != UART0_IIR_NONE) {
+        KLOG1(KLOG_IRQ_UART_TYPE, irq_type);
+    }
+    return FALSE;
+}
+
+/**
+ * @brief   copy out up to len received characters, blocking while there are none
+ * @return  number of characters copied, RTX_ERR on failure
+ * @pre     entered through the uart_rx_recv trap, which holds the kernel
+ *          lock across the empty check and blocking, see the file note
+ */
+int k_uart_rx_recv(char *buf, size_t len)
+{
+    U32 head;
+    U32 tail = g_rx_tail;
+    U32 n;
+
+    if (buf == NULL || len == 0) {
+        return RTX_ERR;
+    }
+
+    while ((head = g_rx_head) == tail) {
+        gp_rx_waiter = gp_current_task;
+        k_tsk_block(BLK_UART);
+    }
+    __dmb(0xF);                         // index is read before the characters it covers
+
+    n = head - tail;
+    if (n > len) {
+        n = len;
+    }
+    for (U32 i = 0; i < n; i++) {
+        buf[i] = g_rx_buf[(tail + i) & (UART_RX_BUF_SIZE - 1)];
+    }
+    __dmb(0xF);                         // characters are read before the slots are handed back
+    g_rx_tail = tail + n;
+
+    return n;
+}
+
+/**
+ * @brief   queue characters for UART0 and return without waiting for them to be sent
+ * @return  number of characters queued, RTX_ERR on failure
+ * @note    only waits for the UART if the TX ring is full
+ */
+int k_uart_tx_write(const char *buf, size_t len)
+{
+    if (buf == NULL) {
+        return RTX_ERR;
+    }
+    return UART0_TxWrite(buf, len);
+}
@@ -0,0 +1,20 @@
+/**
+ * @file:   k_uart.h
+ * @brief:  kernel UART0 buffering header file
+ * @date:   2021/03/04
+ */
+
+#ifndef K_UART_H_
+#define K_UART_H_
+
+#include "k_rtx.h"
+#include "common_ext.h"
+
+#define UART_RX_BUF_SIZE    256     /* received characters buffered, power of 2 */
+
+int k_uart_irq(U32 irq_id, void *arg);
+int k_uart_rx_irq(void);
+int k_uart_rx_recv(char *buf, size_t len);
+int k_uart_tx_write(const char *buf, size_t len);
+
+#endif /* ! K_UART_H_ */
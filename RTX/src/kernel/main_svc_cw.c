@@ -48,6 +48,7 @@
 #include "printf.h"
 #include "k_inc.h"
 #include "k_rtx.h"
+#include "k_log.h"
 
 void task_null (void)
 {
@@ -57,10 +58,22 @@ void task_null (void)
             printf("==============Task NULL===============\r\n");
         }
 #endif
+        k_log_drain();              // format kernel log records while idle
         k_tsk_yield();
     }
 }
 
+/* null task of the CPUs other than CPU 0, started by k_cpu_main */
+void task_null_cpu(void)
+{
+    while (1) {
+        // peek without locks, k_tsk_yield looks again under the queue lock
+        if (check_prio() != RTX_OK || k_rq_can_steal(k_cpu_id())) {
+            k_tsk_yield();
+        }
+    }
+}
+
 int main() 
 {    
     static RTX_SYS_INFO  sys_info;
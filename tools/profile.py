@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+"""Build flat and per-task profiles from RTX profiler samples.
+
+The input is either a console log holding the output of prof_ctl(PROF_DUMP)
+or a raw memory dump of g_kprof, e.g. from the debugger:
+
+    dump binary memory kprof.bin &g_kprof (char *)&g_kprof + sizeof(g_kprof)
+
+Sampled PCs are matched against the function symbols of the image that took
+them, read with nm from the image itself or from a saved nm listing:
+
+    profile.py kprof.log --elf RTX.axf
+    profile.py kprof.bin --syms RTX.nm
+
+usage: profile.py INPUT (--elf IMAGE | --syms NM_LISTING) [--top N]
+"""
+
+import argparse
+import bisect
+import collections
+import struct
+import subprocess
+import sys
+
+KPROF_MAGIC = 0x464F5250
+
+MODES = {0x10: "usr", 0x11: "fiq", 0x12: "irq", 0x13: "svc", 0x17: "abt", 0x1B: "und", 0x1F: "sys"}
+
+TASKS = {0: "null", 157: "null cpu1", 158: "irq worker", 159: "KCD"}
+
+SAMPLE = struct.Struct("<IBBBx")
+
+
+class Profile:
+    def __init__(self):
+        self.num_cpus = 0
+        self.period_us = 0
+        self.dropped = 0
+        self.samples = []           # (cpu, pc, mode, tid)
+
+
+def parse_text(text):
+    prof = Profile()
+    for line in text.splitlines():
+        pos = line.find("kprof: ")
+        if pos < 0:
+            continue
+        f = line[pos + len("kprof: "):].split()
+        if not f or f[0] == "end":
+            continue
+        if f[0] == "begin":
+            kv = dict(zip(f[1::2], f[2::2]))
+            prof.num_cpus = int(kv["cpus"])
+            prof.period_us = int(kv["period_us"])
+            prof.dropped = int(kv["dropped"])
+        else:
+            prof.samples.append((int(f[0]), int(f[1], 16), int(f[2], 16), int(f[3])))
+    return prof
+
+
+def parse_binary(data):
+    prof = Profile()
+    magic, num_cpus, buf_size, period_us, head = struct.unpack_from("<5I", data, 0)
+    if magic != KPROF_MAGIC:
+        sys.exit("not a g_kprof dump")
+    prof.num_cpus = num_cpus
+    prof.period_us = period_us
+    kept = min(head, buf_size)
+    prof.dropped = head - kept
+    for idx in range(kept):
+        pc, mode, cpu, tid = SAMPLE.unpack_from(data, 20 + idx * SAMPLE.size)
+        if mode != 0:
+            prof.samples.append((cpu, pc, mode, tid))
+    return prof
+
+
+class Symbols:
+    def __init__(self, listing):
+        syms = []
+        for line in listing.splitlines():
+            f = line.split()
+            # code symbols only, without the $a/$t/$d mapping symbols
+            if len(f) >= 3 and f[1] in "TtWw" and not f[2].startswith("$"):
+                syms.append((int(f[0], 16), f[2]))
+        syms.sort()
+        self.addrs = [a for a, _ in syms]
+        self.names = [n for _, n in syms]
+
+    def lookup(self, pc):
+        idx = bisect.bisect_right(self.addrs, pc) - 1
+        if idx < 0:
+            return "0x%08x" % pc
+        return self.names[idx]
+
+
+def task_name(tid):
+    return TASKS.get(tid, "task %d" % tid)
+
+
+def print_table(title, counter, total, top):
+    print(title)
+    print("  %8s %6s  %s" % ("samples", "%", "function"))
+    for name, n in counter.most_common(top):
+        print("  %8d %6.2f  %s" % (n, 100.0 * n / total, name))
+    print()
+
+
+def report(prof, syms, top):
+    total = len(prof.samples)
+    if total == 0:
+        sys.exit("no samples found")
+    print("%d samples every %d us on %d cpus, %d dropped" %
+          (total, prof.period_us, prof.num_cpus, prof.dropped))
+    print()
+
+    flat = collections.Counter()
+    modes = collections.Counter()
+    tasks = collections.Counter()
+    per_task = collections.defaultdict(collections.Counter)
+    for cpu, pc, mode, tid in prof.samples:
+        fn = syms.lookup(pc)
+        flat[fn] += 1
+        modes[MODES.get(mode, "0x%x" % mode)] += 1
+        tasks[tid] += 1
+        per_task[tid][fn] += 1
+
+    print("by mode: " + ", ".join("%s %.1f%%" % (m, 100.0 * n / total)
+                                  for m, n in modes.most_common()))
+    print()
+    print_table("flat profile", flat, total, top)
+    for tid, n in tasks.most_common():
+        print_table("%s (tid %d): %d samples, %.2f%%" % (task_name(tid), tid, n, 100.0 * n / total),
+                    per_task[tid], n, top)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("input", help="console log or memory dump of g_kprof")
+    group = parser.add_mutually_exclusive_group(required=True)
+    group.add_argument("--elf", help="image the samples were taken from, read with nm")
+    group.add_argument("--syms", help="nm listing of the image")
+    parser.add_argument("--nm", default="arm-none-eabi-nm", help="nm to read --elf with")
+    parser.add_argument("--top", type=int, default=20, help="functions listed per table")
+    opts = parser.parse_args()
+
+    with open(opts.input, "rb") as f:
+        data = f.read()
+    if len(data) >= 4 and struct.unpack_from("<I", data)[0] == KPROF_MAGIC:
+        prof = parse_binary(data)
+    else:
+        prof = parse_text(data.decode("ascii", "replace"))
+
+    if opts.elf:
+        listing = subprocess.run([opts.nm, "--defined-only", opts.elf], check=True,
+                                 stdout=subprocess.PIPE, universal_newlines=True).stdout
+    else:
+        with open(opts.syms) as f:
+            listing = f.read()
+    report(prof, Symbols(listing), opts.top)
+
+
+if __name__ == "__main__":
+    main()
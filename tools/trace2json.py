@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+"""Convert an RTX kernel event trace into Chrome trace JSON.
+
+The input is either a console log holding the output of trace_ctl(TRACE_DUMP)
+or a raw memory dump of g_ktrace, e.g. from the debugger:
+
+    dump binary memory ktrace.bin &g_ktrace (char *)&g_ktrace + sizeof(g_ktrace)
+
+Open the output in https://ui.perfetto.dev or chrome://tracing. Each CPU gets
+a track of the tasks it ran and a track of the interrupts it took. Wakeups,
+messages and heap calls are instant events on the task track.
+
+usage: trace2json.py INPUT [-o OUTPUT]
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+KTRACE_MAGIC = 0x4B545243
+
+(KTRACE_NONE, KTRACE_SWITCH, KTRACE_STATE, KTRACE_IRQ_ENTER, KTRACE_IRQ_EXIT,
+ KTRACE_MSG_SEND, KTRACE_MSG_RECV, KTRACE_MSG_REPLY, KTRACE_MEM_ALLOC,
+ KTRACE_MEM_FREE) = range(10)
+
+STATES = {
+    0: "DORMANT", 1: "READY", 2: "RUNNING", 4: "BLK_MSG", 5: "SUSPENDED",
+    6: "BLK_CALL", 7: "BLK_REPLY", 8: "BLK_RECV", 9: "BLK_TOPIC",
+    10: "BLK_UART", 11: "BLK_DEFER", 12: "BLK_NOTIFY", 13: "BLK_SEM",
+    14: "BLK_MUTEX",
+}
+
+TASKS = {0: "null", 157: "null cpu1", 158: "irq worker", 159: "KCD"}
+
+REC = struct.Struct("<IBBHII")
+
+
+class Trace:
+    def __init__(self):
+        self.num_cpus = 0
+        self.cycles_per_us = 0
+        self.event_cycles = 0
+        self.sync_cpu = 0
+        self.sync = {}
+        self.lost = {}
+        self.records = {}           # cpu -> [(time, event, tid, arg, a0, a1)], oldest first
+
+
+def parse_text(text):
+    trace = Trace()
+    for line in text.splitlines():
+        pos = line.find("ktrace: ")
+        if pos < 0:
+            continue
+        f = line[pos + len("ktrace: "):].split()
+        if not f or f[0] == "end":
+            continue
+        if f[0] == "begin":
+            kv = dict(zip(f[1::2], f[2::2]))
+            trace.num_cpus = int(kv["cpus"])
+            trace.cycles_per_us = int(kv["cycles_per_us"])
+            trace.event_cycles = int(kv["event_cycles"])
+            trace.sync_cpu = int(kv["sync_cpu"])
+        elif f[0] == "sync":
+            trace.sync[int(f[1])] = int(f[2])
+        elif f[0] == "lost":
+            trace.lost[int(f[1])] = int(f[2])
+        else:
+            cpu = int(f[0])
+            rec = (int(f[1], 16), int(f[2]), int(f[3]), int(f[4]), int(f[5], 16), int(f[6], 16))
+            trace.records.setdefault(cpu, []).append(rec)
+    return trace
+
+
+def parse_binary(data):
+    trace = Trace()
+    magic, num_cpus, buf_size, cpu_us, ev_cycles, sync_cpu = struct.unpack_from("<6I", data, 0)
+    if magic != KTRACE_MAGIC:
+        sys.exit("not a g_ktrace dump")
+    trace.num_cpus = num_cpus
+    trace.cycles_per_us = cpu_us
+    trace.event_cycles = ev_cycles
+    trace.sync_cpu = sync_cpu
+    off = 24
+    for cpu in range(num_cpus):
+        trace.sync[cpu] = struct.unpack_from("<I", data, off)[0]
+        off += 4
+    for cpu in range(num_cpus):
+        head = struct.unpack_from("<I", data, off)[0]
+        base = off + 4
+        start = max(0, head - buf_size)
+        if start:
+            trace.lost[cpu] = start
+        recs = []
+        for idx in range(start, head):
+            rec = REC.unpack_from(data, base + (idx % buf_size) * REC.size)
+            if rec[1] != KTRACE_NONE:
+                recs.append(rec)
+        trace.records[cpu] = recs
+        off = base + buf_size * REC.size
+    return trace
+
+
+def task_name(tid):
+    return TASKS.get(tid, "task %d" % tid)
+
+
+def convert(trace):
+    if trace.cycles_per_us == 0:
+        sys.exit("no trace header found")
+    ref = trace.sync.get(trace.sync_cpu, 0)
+    events = [{"ph": "M", "pid": 0, "name": "process_name", "args": {"name": "RTX"}}]
+
+    for cpu, recs in sorted(trace.records.items()):
+        task_track = cpu * 2
+        irq_track = cpu * 2 + 1
+        events.append({"ph": "M", "pid": 0, "tid": task_track, "name": "thread_name",
+                       "args": {"name": "cpu %d" % cpu}})
+        events.append({"ph": "M", "pid": 0, "tid": irq_track, "name": "thread_name",
+                       "args": {"name": "cpu %d irq" % cpu}})
+        if not recs:
+            continue
+
+        # cycles since this CPU sampled its counter for TRACE_START, then
+        # unwrapped; IRQs can stamp a record slightly before the one ahead
+        # of it in the ring, so small backwards steps are kept as they are
+        base = trace.sync.get(cpu, ref)
+        prev = 0
+        cycles = 0
+        timed = []
+        for rec in recs:
+            raw = (rec[0] - base) & 0xFFFFFFFF
+            delta = (raw - prev) & 0xFFFFFFFF
+            if delta >= 0x80000000:
+                delta -= 0x100000000
+            cycles += delta
+            prev = raw
+            timed.append((cycles / trace.cycles_per_us, rec))
+
+        running = None          # (task, start us) on this CPU
+        irq_depth = 0
+        for ts, (_, event, tid, arg, a0, a1) in timed:
+            if event == KTRACE_SWITCH:
+                start = running[1] if running else timed[0][0]
+                events.append({"ph": "X", "pid": 0, "tid": task_track, "name": task_name(arg),
+                               "ts": start, "dur": ts - start,
+                               "args": {"tid": arg, "left in": STATES.get(a0, a0)}})
+                running = (tid, ts)
+            elif event == KTRACE_IRQ_ENTER:
+                irq_depth += 1
+                events.append({"ph": "B", "pid": 0, "tid": irq_track, "name": "irq %d" % arg,
+                               "ts": ts, "args": {"task": tid}})
+            elif event == KTRACE_IRQ_EXIT:
+                if irq_depth == 0:
+                    continue        # its entry was overwritten
+                irq_depth -= 1
+                events.append({"ph": "E", "pid": 0, "tid": irq_track, "ts": ts,
+                               "args": {"resched": a0}})
+            else:
+                if event == KTRACE_STATE:
+                    name = "%s %s" % (task_name(arg), STATES.get(a0, a0))
+                    args = {"tid": arg, "state": STATES.get(a0, a0)}
+                elif event == KTRACE_MSG_SEND:
+                    name, args = "msg_call", {"server": arg, "len": a0}
+                elif event == KTRACE_MSG_RECV:
+                    name, args = "msg_receive", {"client": arg, "len": a0}
+                elif event == KTRACE_MSG_REPLY:
+                    name, args = "msg_reply", {"client": arg, "len": a0}
+                elif event == KTRACE_MEM_ALLOC:
+                    name, args = "mem_alloc", {"size": a0, "block": "0x%x" % a1}
+                elif event == KTRACE_MEM_FREE:
+                    name, args = "mem_dealloc", {"block": "0x%x" % a0, "ret": a1}
+                else:
+                    name, args = "event %d" % event, {"arg": arg, "a0": a0, "a1": a1}
+                args["task"] = tid
+                events.append({"ph": "i", "s": "t", "pid": 0, "tid": task_track,
+                               "name": name, "ts": ts, "args": args})
+        if running:
+            end = timed[-1][0]
+            events.append({"ph": "X", "pid": 0, "tid": task_track, "name": task_name(running[0]),
+                           "ts": running[1], "dur": end - running[1], "args": {"tid": running[0]}})
+
+    return {
+        "traceEvents": events,
+        "displayTimeUnit": "ns",
+        "otherData": {
+            "cycles_per_us": trace.cycles_per_us,
+            "event_cycles": trace.event_cycles,
+            "lost": {str(cpu): n for cpu, n in trace.lost.items()},
+        },
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("input", help="console log or memory dump of g_ktrace")
+    parser.add_argument("-o", "--output", default="-", help="JSON file, stdout by default")
+    opts = parser.parse_args()
+
+    with open(opts.input, "rb") as f:
+        data = f.read()
+    if len(data) >= 4 and struct.unpack_from("<I", data)[0] == KTRACE_MAGIC:
+        trace = parse_binary(data)
+    else:
+        trace = parse_text(data.decode("ascii", "replace"))
+
+    for cpu, n in sorted(trace.lost.items()):
+        print("cpu %d: %d oldest events were overwritten" % (cpu, n), file=sys.stderr)
+    print("%d cycles per event, %d cycles per us" % (trace.event_cycles, trace.cycles_per_us),
+          file=sys.stderr)
+
+    out = sys.stdout if opts.output == "-" else open(opts.output, "w")
+    json.dump(convert(trace), out)
+    if out is not sys.stdout:
+        out.close()
+
+
+if __name__ == "__main__":
+    main()